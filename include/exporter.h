@@ -0,0 +1,54 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "system.h"
+
+struct ExporterOptions {
+  std::string socket_path;  // Unix domain socket, used if not empty
+  int port{0};              // localhost TCP port, used if not 0
+  std::size_t top{20};      // processes exported, in the display order
+};
+
+/*
+OpenMetrics exporter of the system snapshot.
+The response to a scrape is rendered once per snapshot by Publish(), on the
+thread that updates the System; the exporter thread only sends the last
+rendered response, so scrapes never read /proc nor render anything.
+*/
+class Exporter {
+ public:
+  explicit Exporter(ExporterOptions const& options);
+  Exporter(Exporter const&) = delete;
+  Exporter& operator=(Exporter const&) = delete;
+  ~Exporter();
+  bool Start(std::string& error);
+  void Stop();
+  void Publish(System& system);
+
+ private:
+  void Serve();
+  void Respond(int fd);
+  void Render(System& system, std::string& body);
+
+  ExporterOptions options;
+  int listen_fd{-1};
+  std::atomic<bool> running{false};
+  std::thread thread;
+
+  std::mutex mutex;
+  std::shared_ptr<std::string> response;
+  std::shared_ptr<std::string> spare;
+  std::string body;
+  std::string labels;
+  std::vector<std::size_t> label_ends;
+};
+
+#endif
@@ -1,18 +1,26 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <array>
 #include <fstream>
+#include <memory_resource>
 #include <regex>
-#include <set>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace LinuxParser {
 // Paths
 const std::string kProcDirectory{"/proc/"};
 const std::string kCmdlineFilename{"/cmdline"};
+const std::string kCommFilename{"/comm"};
 const std::string kCpuinfoFilename{"/cpuinfo"};
-const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
+const std::string kStatusFilename{"/status"};
+const std::string kIoFilename{"/io"};
+const std::string kSchedstatFilename{"/schedstat"};
+const std::string kSmapsRollupFilename{"/smaps_rollup"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
 const std::string kVersionFilename{"/version"};
@@ -26,21 +34,22 @@ const std::string fMemTotal("MemTotal:");
 const std::string fMemFree("MemAvailable:");
 const std::string fCpu("cpu");
 const std::string fUID("Uid:");
-const std::string fProcMem("VmRSS:");
+const std::string fReadBytes("read_bytes:");
+const std::string fWriteBytes("write_bytes:");
+const std::string fPss("Pss:");
+const std::string fPssAnon("Pss_Anon:");
+const std::string fPssFile("Pss_File:");
+const std::string fPssShmem("Pss_Shmem:");
+const std::string fPrivateClean("Private_Clean:");
+const std::string fPrivateDirty("Private_Dirty:");
+const std::string fSwap("Swap:");
 
-// System
-float MemoryUtilization();
-long UpTime();
-long TotalProcesses();
-long RunningProcesses();
-long Jiffies();
-long ActiveJiffies();
-long ActiveJiffies(long pid);
-long IdleJiffies();
-std::set<long> Pids();
-std::string OperatingSystem();
-std::string Kernel();
-std::vector<std::string> CpuUtilization();
+// Scratch memory
+void ScratchResource(std::pmr::memory_resource* resource);
+std::pmr::memory_resource* ScratchResource();
+std::pmr::string Path(std::string const& filename);
+std::pmr::string Path(long pid, std::string const& filename);
+bool ReadFile(std::pmr::string const& path, std::pmr::string& content);
 
 // CPU
 enum CPUStates {
@@ -56,12 +65,56 @@ enum CPUStates {
   kGuestNice_
 };
 
+// System
+float MemoryUtilization();
+long UpTime();
+double UpTimeSeconds();
+long TotalProcesses();
+long RunningProcesses();
+long Jiffies();
+long ActiveJiffies();
+long IdleJiffies();
+std::vector<long> Pids();
+void Pids(std::vector<long>& pids);
+std::string OperatingSystem();
+std::string Kernel();
+std::array<long, kGuestNice_ + 1> CpuUtilization();
+std::vector<std::pair<long, std::string>> Users();
+
 // Processes
+struct ProcessIo {
+  long read_bytes{0};
+  long write_bytes{0};
+};
+
+struct ProcessSchedstat {
+  unsigned long long run_time{0};   // time spent on a CPU (ns)
+  unsigned long long wait_time{0};  // time spent waiting on a run queue (ns)
+  unsigned long long timeslices{0};
+};
+
+// memory of a process from smaps_rollup, in kB
+struct ProcessMemory {
+  unsigned long long pss{0};
+  unsigned long long pss_anon{0};  // zero before Linux 5.13
+  unsigned long long pss_file{0};
+  unsigned long long pss_shmem{0};
+  unsigned long long private_clean{0};
+  unsigned long long private_dirty{0};
+  unsigned long long swap{0};
+};
+
+bool Io(long pid, ProcessIo& io, std::pmr::string& content);
+ProcessIo ParseIo(std::string_view content);
+bool Schedstat(long pid, ProcessSchedstat& schedstat,
+               std::pmr::string& content);
+ProcessSchedstat ParseSchedstat(std::string_view content);
+bool Memory(long pid, ProcessMemory& memory, std::pmr::string& content);
+ProcessMemory ParseMemory(std::string_view content);
 std::string Command(long pid);
-std::string Ram(long pid);
-std::string Uid(long pid);
-std::string User(long pid);
-long UpTime(long pid);
+std::string Comm(long pid);
+long Uid(long pid);
+long ParseUid(std::string_view content);
 };  // namespace LinuxParser
 
 #endif
\ No newline at end of file
@@ -3,14 +3,22 @@
 
 #include <curses.h>
 
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "exporter.h"
 #include "process.h"
+#include "process_table.h"
 #include "system.h"
 
 namespace NCursesDisplay {
-void Display(System& system, int n = 20);
+void Display(System& system, int n = 20, Exporter* exporter = nullptr);
 void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::set<Process>& processes, WINDOW* window, int n);
-std::string ProgressBar(float percent);
+void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n,
+                      ProcessTable::SortKey key = ProcessTable::SortKey::kCpu);
+std::pmr::string ProgressBar(float percent,
+                             std::pmr::memory_resource* resource);
 };  // namespace NCursesDisplay
 
 #endif
\ No newline at end of file
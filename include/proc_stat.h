@@ -0,0 +1,146 @@
+#ifndef PROC_STAT_H
+#define PROC_STAT_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "linux_parser.h"
+
+namespace LinuxParser {
+/*
+Fields of /proc/<pid>/stat, see proc(5).
+Only the fields a caller asks for are parsed, the others keep their
+default values; comm is always copied.
+*/
+struct ProcessStat {
+  std::array<char, 16> comm{};  // executable name, NUL terminated
+  char state{'?'};
+  long ppid{0};
+  unsigned long utime{0};   // CPU time spent in user code (clock ticks)
+  unsigned long stime{0};   // CPU time spent in kernel code (clock ticks)
+  long cutime{0};           // waited-for children's user time (clock ticks)
+  long cstime{0};           // waited-for children's kernel time (clock ticks)
+  long num_threads{0};
+  unsigned long long starttime{0};  // start time after boot (clock ticks)
+  unsigned long vsize{0};           // virtual memory size (bytes)
+  long rss{0};                      // resident set size (pages)
+};
+
+/*
+A field of the schema: its position in the file (numbered from 1 as in
+proc(5)) and the ProcessStat member it is parsed into, which also fixes its
+type. Positions before 3 (pid, comm) are not supported.
+*/
+template <int Index, auto Member>
+struct StatField {
+  static_assert(Index > 2, "pid and comm are not part of the stat schema");
+  static constexpr int index = Index;
+  static constexpr auto member = Member;
+};
+
+// The schema. Supporting a new field is one line here plus its member above.
+namespace StatFields {
+using State = StatField<3, &ProcessStat::state>;
+using Ppid = StatField<4, &ProcessStat::ppid>;
+using Utime = StatField<14, &ProcessStat::utime>;
+using Stime = StatField<15, &ProcessStat::stime>;
+using Cutime = StatField<16, &ProcessStat::cutime>;
+using Cstime = StatField<17, &ProcessStat::cstime>;
+using NumThreads = StatField<20, &ProcessStat::num_threads>;
+using Starttime = StatField<22, &ProcessStat::starttime>;
+using Vsize = StatField<23, &ProcessStat::vsize>;
+using Rss = StatField<24, &ProcessStat::rss>;
+};  // namespace StatFields
+
+/**
+ * @brief Parse one token into the member of a schema field
+ *
+ * @tparam Field schema field
+ * @param stat destination struct
+ * @param first token start
+ * @param last token end
+ * @return true if the whole token was a valid value
+ */
+template <typename Field>
+bool ParseStatField(ProcessStat& stat, char const* first, char const* last) {
+  auto& value = stat.*Field::member;
+  if constexpr (std::is_same_v<std::remove_reference_t<decltype(value)>,
+                               char>) {
+    value = *first;
+    return last - first == 1;
+  } else {
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last;
+  }
+}
+
+/**
+ * @brief Parse the requested fields of a /proc/<pid>/stat line
+ *
+ * The line is scanned once, from the end of comm (which may contain spaces
+ * and parentheses) up to the highest requested field.
+ *
+ * @tparam Fields schema fields to parse
+ * @param line content of the stat file
+ * @param stat destination of the parsed fields
+ * @return true if every requested field was parsed
+ */
+template <typename... Fields>
+bool ParseStat(std::string_view line, ProcessStat& stat) {
+  constexpr int last = std::max({Fields::index...});
+
+  auto comm_begin = line.find('(');
+  auto comm_end = line.rfind(')');
+  if (comm_begin == std::string_view::npos ||
+      comm_end == std::string_view::npos || comm_end < comm_begin) {
+    return false;
+  }
+  auto comm = line.substr(comm_begin + 1, comm_end - comm_begin - 1);
+  comm = comm.substr(0, stat.comm.size() - 1);
+  std::copy(comm.begin(), comm.end(), stat.comm.begin());
+  stat.comm[comm.size()] = '\0';
+
+  char const* cursor = line.data() + comm_end + 1;
+  char const* end = line.data() + line.size();
+  bool valid{true};
+  for (int field = 3; field <= last; ++field) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\n')) {
+      ++cursor;
+    }
+    char const* token = cursor;
+    while (cursor < end && *cursor != ' ' && *cursor != '\n') {
+      ++cursor;
+    }
+    if (token == cursor) {
+      return false;
+    }
+    ((Fields::index == field &&
+      (valid = ParseStatField<Fields>(stat, token, cursor) && valid)),
+     ...);
+  }
+  return valid;
+}
+
+/**
+ * @brief Read the requested fields of /proc/<pid>/stat, through a reusable
+ * buffer
+ *
+ * @tparam Fields schema fields to parse
+ * @param pid process PID
+ * @param stat destination of the parsed fields
+ * @param content buffer for the file content
+ * @return true if the file was read and every requested field was parsed
+ */
+template <typename... Fields>
+bool Stat(long pid, ProcessStat& stat, std::pmr::string& content) {
+  return ReadFile(Path(pid, kStatFilename), content) &&
+         ParseStat<Fields...>(content, stat);
+}
+};  // namespace LinuxParser
+
+#endif
@@ -1,24 +1,35 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
-#include <string>
+#include <cstddef>
+#include <string_view>
+
+#include "process_table.h"
+
 /*
 Basic class for Process representation
-It contains relevant attributes as shown below
+It is a view of one process of the ProcessTable, through a handle: once the
+process exited or its slot was reused, the attributes below are empty.
 */
 class Process {
  public:
-  Process(long pid);
-  std::string User() const;
-  std::string Command() const;
-  std::string Ram() const;
+  Process(ProcessTable const& table, ProcessTable::Handle handle);
+  bool Valid() const;
+  std::string_view User() const;
+  std::string_view Command() const;
+  double Ram() const;
+  double Pss() const;
+  double Uss() const;
+  double MemoryAge() const;
   float CpuUtilization() const;
+  float RunDelay() const;
+  float WaitRatio() const;
   long Pid() const;
   long int UpTime() const;
-  bool operator<(Process const& a) const;
 
  private:
-  long pid;
+  ProcessTable const* table;
+  ProcessTable::Handle handle;
 };
 
-#endif
\ No newline at end of file
+#endif
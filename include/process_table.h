@@ -0,0 +1,173 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_stat.h"
+#include "string_pool.h"
+#include "uring_reader.h"
+
+/*
+Structure-of-arrays table of the processes being tracked.
+Every column is a contiguous vector indexed by slot. Slots of exited
+processes are recycled through a free list and their generation is bumped,
+so a Handle taken before the process exited (or its pid was reused) can be
+detected as stale.
+Command lines and user names are read when a process is first seen, and
+again when its comm changes (it called exec), and are interned in a
+StringPool.
+The per-process files are read synchronously, or in batches through
+io_uring once UseIoUring() succeeded.
+The memory breakdown from smaps_rollup is too expensive to read for every
+process on every tick: the first rows of the order are read every tick,
+the others round-robin until the memory budget of the tick is spent, and
+each value keeps the time it was read at.
+*/
+class ProcessTable {
+ public:
+  struct Handle {
+    std::uint32_t slot;
+    std::uint32_t generation;
+  };
+
+  enum class SortKey { kCpu, kRunDelay };
+
+  void Update();
+  bool UseIoUring();
+  void MemoryBudget(std::size_t priority, std::chrono::microseconds budget);
+  void SortBy(SortKey key);
+  SortKey SortedBy() const { return this->sort_key; }
+  std::vector<std::uint32_t> const& Order() const;
+  std::size_t Size() const;
+  Handle HandleOf(std::uint32_t slot) const;
+  bool Valid(Handle handle) const;
+  std::size_t Bytes() const;
+  std::size_t BytesPerProcess() const;
+
+  long Pid(std::size_t slot) const { return this->pids[slot]; }
+  float CpuUtilization(std::size_t slot) const { return this->cpu[slot]; }
+  float RunDelay(std::size_t slot) const { return this->run_delays[slot]; }
+  float WaitRatio(std::size_t slot) const { return this->wait_ratios[slot]; }
+  std::uint64_t WaitTime(std::size_t slot) const {
+    return this->wait_times[slot];
+  }
+  float TotalRunDelay() const { return this->total_run_delay; }
+  float TotalWaitRatio() const { return this->total_wait_ratio; }
+  long UpTime(std::size_t slot) const;
+  double RamMegabytes(std::size_t slot) const;
+  double MemoryAge(std::size_t slot) const;
+  std::uint64_t Pss(std::size_t slot) const { return this->pss[slot]; }
+  std::uint64_t Uss(std::size_t slot) const { return this->uss[slot]; }
+  std::uint64_t Swap(std::size_t slot) const { return this->swap[slot]; }
+  std::uint64_t PssAnon(std::size_t slot) const {
+    return this->pss_anon[slot];
+  }
+  std::uint64_t PssFile(std::size_t slot) const {
+    return this->pss_file[slot];
+  }
+  std::uint64_t TotalPss() const { return this->total_pss; }
+  std::size_t MemoryCovered() const { return this->memory_covered; }
+  double OldestMemoryAge() const { return this->oldest_memory_age; }
+  std::string_view Command(std::size_t slot) const {
+    return this->strings.Get(this->commands[slot]);
+  }
+  std::string_view User(std::size_t slot) const {
+    return this->strings.Get(this->users[slot]);
+  }
+  std::uint64_t ReadBytes(std::size_t slot) const {
+    return this->read_bytes[slot];
+  }
+  std::uint64_t WriteBytes(std::size_t slot) const {
+    return this->write_bytes[slot];
+  }
+
+ private:
+  std::uint32_t Acquire(long pid);
+  void Release(std::uint32_t slot);
+  void Reset(std::uint32_t slot);
+  void Sample(std::uint32_t slot, std::pmr::string& content);
+  void SampleBatch(std::pmr::string& content);
+  void Store(std::uint32_t slot, LinuxParser::ProcessStat const& stat,
+             LinuxParser::ProcessIo const* io,
+             LinuxParser::ProcessSchedstat const* schedstat,
+             std::pmr::string& content);
+  void Identify(std::uint32_t slot, std::pmr::string& content);
+  void SampleMemory(std::pmr::string& content);
+  void ReadMemory(std::uint32_t slot, std::pmr::string& content);
+  StringPool::Id UserName(long uid);
+  void Rates(double seconds);
+  void Sort();
+
+  // columns, indexed by slot
+  std::vector<std::int32_t> pids;
+  std::vector<std::uint32_t> generations;
+  std::vector<std::uint32_t> seen;
+  std::vector<std::uint8_t> fresh;
+  std::vector<std::uint64_t> start_times;
+  std::vector<std::uint64_t> utimes;
+  std::vector<std::uint64_t> stimes;
+  std::vector<std::uint64_t> last_ticks;
+  std::vector<std::uint64_t> rss;
+  std::vector<std::uint64_t> read_bytes;
+  std::vector<std::uint64_t> write_bytes;
+  std::vector<std::uint64_t> run_times;
+  std::vector<std::uint64_t> wait_times;
+  std::vector<std::uint64_t> last_run_times;
+  std::vector<std::uint64_t> last_wait_times;
+  std::vector<std::uint32_t> scheduled;  // tick of the last schedstat read
+  std::vector<std::uint64_t> pss;
+  std::vector<std::uint64_t> uss;
+  std::vector<std::uint64_t> swap;
+  std::vector<std::uint64_t> pss_anon;
+  std::vector<std::uint64_t> pss_file;
+  std::vector<std::chrono::steady_clock::time_point> memory_times;
+  std::vector<float> cpu;
+  std::vector<float> run_delays;
+  std::vector<float> wait_ratios;
+  std::vector<std::uint32_t> comm_hashes;
+  std::vector<StringPool::Id> commands;
+  std::vector<StringPool::Id> users;
+
+  std::vector<std::uint32_t> free_slots;
+  std::vector<std::uint32_t> order;
+  std::unordered_map<long, std::uint32_t> slots;
+  std::vector<long> listing;
+
+  StringPool strings;
+  std::unordered_map<long, StringPool::Id> user_names;
+
+  // io_uring backend: slots waiting for their files, and the batch buffers
+  std::unique_ptr<UringReader> uring;
+  std::vector<std::uint32_t> pending;
+  std::vector<std::array<char, 32>> paths;
+  std::vector<UringReader::Request> requests;
+  std::vector<char> buffers;
+
+  // memory breakdown: rows read every tick, time budget of the others, and
+  // where the round-robin resumes
+  std::size_t memory_priority{20};
+  std::chrono::microseconds memory_budget{5000};
+  std::uint32_t memory_cursor{0};
+  std::uint64_t total_pss{0};
+  std::size_t memory_covered{0};
+  double oldest_memory_age{0};
+
+  SortKey sort_key{SortKey::kCpu};
+  float total_run_delay{0};
+  float total_wait_ratio{0};
+  std::uint32_t tick{0};
+  double uptime{0};
+  std::chrono::steady_clock::time_point sampled{};
+};
+
+#endif
@@ -6,8 +6,8 @@ class Processor {
   float Utilization();
 
  private:
-  float idle;
-  float total;
+  float idle{0};
+  float total{0};
 };
 
 #endif
\ No newline at end of file
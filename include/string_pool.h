@@ -0,0 +1,36 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+Pool of reference counted, deduplicated strings.
+Equal strings share one id; an id is recycled once its last reference is
+released. Id 0 is the empty string and is never released.
+*/
+class StringPool {
+ public:
+  using Id = std::uint32_t;
+  static constexpr Id kEmpty{0};
+
+  StringPool();
+  Id Intern(std::string_view value);
+  void Release(Id id);
+  std::string_view Get(Id id) const { return this->strings[id]; }
+  std::size_t Size() const { return this->index.size(); }
+
+ private:
+  // a deque never moves its elements, so the views in index stay valid
+  std::deque<std::string> strings;
+  std::vector<std::uint32_t> references;
+  std::vector<Id> free_ids;
+  std::unordered_map<std::string_view, Id> index;
+};
+
+#endif
@@ -1,28 +1,55 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
-#include <set>
+#include <array>
+#include <cstddef>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
 #include "process.h"
+#include "process_table.h"
 #include "processor.h"
 
 class System {
  public:
+  ~System();
   Processor& Cpu();
-  std::set<Process>& Processes();
+  float CpuUtilization();
+  std::vector<Process>& Processes();
+  ProcessTable& Table();
   float MemoryUtilization();
+  double ProportionalMemory();
   long UpTime();
   long TotalProcesses();
   long RunningProcesses();
+  void update();
   void updateProcesses();
-  std::string Kernel();
-  std::string OperatingSystem();
+  void SortBy(ProcessTable::SortKey key);
+  float RunDelay();
+  float WaitRatio();
+  std::string const& Kernel();
+  std::string const& OperatingSystem();
+  std::pmr::memory_resource* Arena();
 
  private:
+  // scratch memory of the current tick, released by update()
+  std::array<std::byte, 1 << 16> arena_buffer;
+  std::pmr::monotonic_buffer_resource arena{arena_buffer.data(),
+                                            arena_buffer.size()};
+
   Processor cpu = Processor();
-  std::set<Process> proc;
+  ProcessTable table;
+  std::vector<Process> proc;
+
+  // snapshot taken by the last update()
+  std::string kernel;
+  std::string os;
+  float cpu_utilization{0};
+  float memory_utilization{0};
+  long uptime{0};
+  long total_processes{0};
+  long running_processes{0};
 };
 
 #endif
\ No newline at end of file
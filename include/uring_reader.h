@@ -0,0 +1,66 @@
+#ifndef URING_READER_H
+#define URING_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/*
+Batched file reader on top of io_uring (raw system calls, no liburing).
+A batch of files is opened with one submission, then read and closed with
+a second one, instead of three system calls per file.
+Available() is false when the kernel (or a seccomp policy) refuses
+io_uring, when it lacks the open, read or close operations (before Linux
+5.6), or after the ring failed; callers then read the files synchronously.
+*/
+class UringReader {
+ public:
+  struct Request {
+    char const* path;
+    char* buffer;
+    std::size_t capacity;
+    long result;  // bytes read, or -errno
+  };
+
+  explicit UringReader(unsigned entries = 256);
+  UringReader(UringReader const&) = delete;
+  UringReader& operator=(UringReader const&) = delete;
+  ~UringReader();
+  bool Available() const { return this->ring_fd >= 0; }
+  void Read(Request* requests, std::size_t count);
+
+ private:
+  bool Probe();
+  io_uring_sqe* NextSqe();
+  bool Submit(unsigned count, unsigned wait);
+  template <typename Complete>
+  bool Reap(unsigned count, Complete complete);
+  bool ReadChunk(Request* requests, std::size_t count);
+  void Teardown();
+
+  int ring_fd{-1};
+  unsigned entries{0};
+
+  void* sq_ring{nullptr};
+  std::size_t sq_ring_size{0};
+  void* cq_ring{nullptr};
+  std::size_t cq_ring_size{0};
+  io_uring_sqe* sqes{nullptr};
+  std::size_t sqes_size{0};
+
+  unsigned* sq_head{nullptr};
+  unsigned* sq_tail{nullptr};
+  unsigned* sq_mask{nullptr};
+  unsigned* sq_array{nullptr};
+  unsigned* cq_head{nullptr};
+  unsigned* cq_tail{nullptr};
+  unsigned* cq_mask{nullptr};
+  io_uring_cqe* cqes{nullptr};
+
+  std::vector<int> fds;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include <time.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+Fixed capacity ring of samples, overwriting the oldest sample when full.
+Index 0 is the oldest sample kept.
+*/
+template <typename T>
+class RingBuffer {
+ public:
+  explicit RingBuffer(std::size_t capacity) : data(capacity) {}
+  void Push(T const& value) {
+    this->data[(this->head + this->size) % this->data.size()] = value;
+    if (this->size < this->data.size()) {
+      ++this->size;
+    } else {
+      this->head = (this->head + 1) % this->data.size();
+    }
+  }
+  std::size_t Size() const { return this->size; }
+  T const& operator[](std::size_t i) const {
+    return this->data[(this->head + i) % this->data.size()];
+  }
+
+ private:
+  std::vector<T> data;
+  std::size_t head{0};
+  std::size_t size{0};
+};
+
+struct WatchOptions {
+  std::vector<long> pids;
+  std::string pattern;  // regex matched against command names
+  std::chrono::milliseconds interval{10};
+  std::chrono::milliseconds window{1000};
+  std::size_t capacity{4096};  // samples kept per process
+};
+
+/*
+High frequency sampler for a chosen set of processes.
+Targets are resolved once; afterwards only their stat files and the first
+line of /proc/stat are read, through file descriptors kept open for the
+whole run. Percentiles of each window are written to stdout.
+CPU time comes from the CPU-time clock of each process, in nanoseconds and
+including the threads that already exited: the clock ticks of
+/proc/<pid>/stat are as long as the sampling interval.
+*/
+class Watcher {
+ public:
+  explicit Watcher(WatchOptions const& options);
+  Watcher(Watcher const&) = delete;
+  Watcher& operator=(Watcher const&) = delete;
+  ~Watcher();
+  int Run();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Sample {
+    Clock::time_point time;
+    float cpu;
+    long rss;
+  };
+
+  struct Target {
+    long pid;
+    std::string command;
+    int fd;
+    bool has_clock;  // false: CPU time from the clock ticks of stat
+    clockid_t clock;
+    double cpu_time;  // seconds
+    Clock::time_point sampled;
+    RingBuffer<Sample> samples;
+  };
+
+  void Resolve();
+  bool SampleSystem(Clock::time_point now);
+  bool SampleTarget(Target& target, Clock::time_point now);
+  void Report(Clock::time_point now);
+  void ReportLine(RingBuffer<Sample> const& samples, Clock::time_point now);
+
+  WatchOptions options;
+  std::vector<Target> targets;
+  int stat_fd{-1};
+  unsigned long total{0};
+  unsigned long idle{0};
+  Clock::time_point system_sampled{};
+  RingBuffer<Sample> system;
+  std::vector<float> scratch;
+  std::array<char, 4096> buffer{};
+};
+
+#endif
@@ -0,0 +1,478 @@
+#include "exporter.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "process_table.h"
+#include "system.h"
+
+const std::string kContentType{
+    "application/openmetrics-text; version=1.0.0; charset=utf-8"};
+
+// how long a scrape may hold the exporter thread, which serves one at a time
+const std::chrono::milliseconds kRequestTimeout{200};
+const std::chrono::milliseconds kResponseTimeout{1000};
+
+/**
+ * @brief Append an integer to a buffer, without temporaries
+ *
+ * @param buffer
+ * @param value
+ */
+template <typename T>
+void AppendValue(std::string& buffer, T value) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+/**
+ * @brief Append a floating point value to a buffer, without temporaries
+ *
+ * @param buffer
+ * @param value
+ */
+template <>
+void AppendValue<double>(std::string& buffer, double value) {
+  if (std::isnan(value)) {
+    buffer.append("NaN");
+    return;
+  }
+  // byte counts are exact, %g would round them to 6 digits
+  if (value == std::floor(value) && std::fabs(value) < 9e15) {
+    AppendValue(buffer, static_cast<long long>(value));
+    return;
+  }
+  char digits[32];
+  int length = std::snprintf(digits, sizeof(digits), "%.6g", value);
+  buffer.append(digits, length);
+}
+
+/**
+ * @brief Append the TYPE and HELP lines of a metric family
+ *
+ * @param buffer
+ * @param name metric family name
+ * @param type gauge or counter
+ * @param help description
+ */
+void AppendFamily(std::string& buffer, char const* name, char const* type,
+                  char const* help) {
+  buffer.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+  buffer.append("# HELP ").append(name).append(" ").append(help).append("\n");
+}
+
+/**
+ * @brief Append a label value, escaped as OpenMetrics requires
+ *
+ * @param buffer
+ * @param value
+ */
+void AppendLabel(std::string& buffer, std::string_view value) {
+  for (char c : value) {
+    if (c == '\0') {
+      break;
+    } else if (c == '\\' || c == '"') {
+      buffer.push_back('\\');
+      buffer.push_back(c);
+    } else if (c == '\n') {
+      buffer.append("\\n");
+    } else {
+      buffer.push_back(c);
+    }
+  }
+}
+
+/**
+ * @brief Remove the socket a previous run left at a path
+ *
+ * Anything else found there is kept: the path may have been mistyped.
+ *
+ * @param path socket path
+ * @param error reason of the failure
+ * @return true if nothing is left at the path
+ */
+bool RemoveSocket(std::string const& path, std::string& error) {
+  struct stat info;
+  if (lstat(path.c_str(), &info) < 0) {
+    if (errno == ENOENT) {
+      return true;
+    }
+    error = "cannot stat " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  if (!S_ISSOCK(info.st_mode)) {
+    error = path + " exists and is not a socket";
+    return false;
+  }
+  if (unlink(path.c_str()) < 0) {
+    error = "cannot remove " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Construct a new Exporter:: Exporter object
+ *
+ * @param options where to listen and how many processes to export
+ */
+Exporter::Exporter(ExporterOptions const& options) : options(options) {}
+
+/**
+ * @brief Destroy the Exporter:: Exporter object, stopping its thread
+ *
+ */
+Exporter::~Exporter() { this->Stop(); }
+
+/**
+ * @brief Bind the listening socket and start the exporter thread
+ *
+ * @param error reason of the failure
+ * @return true if the exporter is serving
+ */
+bool Exporter::Start(std::string& error) {
+  if (!this->options.socket_path.empty()) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (this->options.socket_path.size() >= sizeof(address.sun_path)) {
+      error = "socket path too long";
+      return false;
+    }
+    std::strcpy(address.sun_path, this->options.socket_path.c_str());
+    if (!RemoveSocket(this->options.socket_path, error)) {
+      return false;
+    }
+    this->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->listen_fd < 0 ||
+        bind(this->listen_fd, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) < 0) {
+      error = "cannot bind " + this->options.socket_path + ": " +
+              std::strerror(errno);
+      return false;
+    }
+  } else {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(this->options.port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int reuse{1};
+    this->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->listen_fd < 0 ||
+        setsockopt(this->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                   sizeof(reuse)) < 0 ||
+        bind(this->listen_fd, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) < 0) {
+      error = "cannot bind 127.0.0.1:" + std::to_string(this->options.port) +
+              ": " + std::strerror(errno);
+      return false;
+    }
+  }
+
+  if (listen(this->listen_fd, 16) < 0) {
+    error = std::string("cannot listen: ") + std::strerror(errno);
+    return false;
+  }
+
+  this->running = true;
+  this->thread = std::thread(&Exporter::Serve, this);
+  return true;
+}
+
+/**
+ * @brief Stop the exporter thread and close the listening socket
+ *
+ */
+void Exporter::Stop() {
+  this->running = false;
+  if (this->thread.joinable()) {
+    this->thread.join();
+  }
+  if (this->listen_fd >= 0) {
+    close(this->listen_fd);
+    this->listen_fd = -1;
+    if (!this->options.socket_path.empty()) {
+      std::string error;
+      RemoveSocket(this->options.socket_path, error);
+    }
+  }
+}
+
+/**
+ * @brief Render the response to the next scrapes from a new snapshot
+ *
+ * Both the body and the response buffers keep their capacity from one
+ * snapshot to the next, so steady state publishing does not allocate.
+ *
+ * @param system updated system
+ */
+void Exporter::Publish(System& system) {
+  this->Render(system, this->body);
+
+  // reuse the previous response unless a scrape is still sending it; the
+  // count is read under the mutex, which orders it after the scrape's
+  // release of its copy
+  std::shared_ptr<std::string> spare;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->spare && this->spare.use_count() == 1) {
+      spare = std::move(this->spare);
+    }
+  }
+  if (!spare) {
+    spare = std::make_shared<std::string>();
+    spare->reserve(this->body.capacity() + 256);
+  }
+  auto& response = *spare;
+  response.assign("HTTP/1.1 200 OK\r\nContent-Type: ");
+  response.append(kContentType).append("\r\nContent-Length: ");
+  AppendValue(response, this->body.size());
+  response.append("\r\nConnection: close\r\n\r\n").append(this->body);
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->spare = std::move(this->response);
+  this->response = std::move(spare);
+}
+
+/**
+ * @brief Render the metrics of a snapshot in OpenMetrics text format
+ *
+ * @param system updated system
+ * @param body destination buffer
+ */
+void Exporter::Render(System& system, std::string& body) {
+  ProcessTable const& table = system.Table();
+  auto const& order = table.Order();
+  std::size_t top = std::min(this->options.top, order.size());
+
+  body.clear();
+  if (body.capacity() == 0) {
+    body.reserve(2048 + top * 512);
+  }
+
+  auto scalar = [&](char const* name, char const* sample, char const* type,
+                    char const* help, auto value) {
+    AppendFamily(body, name, type, help);
+    body.append(sample).append(" ");
+    AppendValue(body, value);
+    body.append("\n");
+  };
+
+  scalar("sysmonitor_cpu_utilization", "sysmonitor_cpu_utilization", "gauge",
+         "Aggregate CPU utilization, from 0 to 1.",
+         static_cast<double>(system.CpuUtilization()));
+  scalar("sysmonitor_memory_utilization", "sysmonitor_memory_utilization",
+         "gauge", "Memory utilization, from 0 to 1.",
+         static_cast<double>(system.MemoryUtilization()));
+  scalar("sysmonitor_proportional_memory_bytes",
+         "sysmonitor_proportional_memory_bytes", "gauge",
+         "Proportional set size of the processes whose memory was read.",
+         table.TotalPss() * 1024);
+  scalar("sysmonitor_uptime_seconds", "sysmonitor_uptime_seconds", "gauge",
+         "Time since the system booted.", system.UpTime());
+  scalar("sysmonitor_processes_created", "sysmonitor_processes_created_total",
+         "counter", "Processes created since the system booted.",
+         system.TotalProcesses());
+  scalar("sysmonitor_processes_running", "sysmonitor_processes_running",
+         "gauge", "Processes in a runnable state.", system.RunningProcesses());
+  scalar("sysmonitor_processes_tracked", "sysmonitor_processes_tracked",
+         "gauge", "Processes tracked by the monitor.", table.Size());
+  scalar("sysmonitor_processes_tracked_bytes",
+         "sysmonitor_processes_tracked_bytes", "gauge",
+         "Memory held by the table of tracked processes.", table.Bytes());
+  scalar("sysmonitor_processes_tracked_bytes_per_process",
+         "sysmonitor_processes_tracked_bytes_per_process", "gauge",
+         "Memory held by the table per tracked process.",
+         table.BytesPerProcess());
+
+  // label sets are rendered once and shared by every per-process family
+  this->labels.clear();
+  this->label_ends.clear();
+  for (std::size_t i = 0; i < top; ++i) {
+    this->labels.append("{pid=\"");
+    AppendValue(this->labels, table.Pid(order[i]));
+    this->labels.append("\",command=\"");
+    AppendLabel(this->labels, table.Command(order[i]));
+    this->labels.append("\"} ");
+    this->label_ends.push_back(this->labels.size());
+  }
+
+  auto family = [&](char const* name, char const* sample, char const* type,
+                    char const* help, auto value) {
+    AppendFamily(body, name, type, help);
+    std::size_t begin{0};
+    for (std::size_t i = 0; i < top; ++i) {
+      body.append(sample).append(this->labels, begin,
+                                 this->label_ends[i] - begin);
+      AppendValue(body, value(order[i]));
+      body.append("\n");
+      begin = this->label_ends[i];
+    }
+  };
+
+  family("sysmonitor_process_cpu_utilization",
+         "sysmonitor_process_cpu_utilization", "gauge",
+         "CPU utilization of the process over the last interval.",
+         [&](std::size_t slot) {
+           return static_cast<double>(table.CpuUtilization(slot));
+         });
+  family("sysmonitor_process_resident_memory_bytes",
+         "sysmonitor_process_resident_memory_bytes", "gauge",
+         "Resident set size of the process.", [&](std::size_t slot) {
+           return table.RamMegabytes(slot) * 1024 * 1024;
+         });
+  // the breakdown of processes whose smaps_rollup was never read is unknown
+  auto memory = [&](std::uint64_t (ProcessTable::*column)(std::size_t) const) {
+    return [&table, column](std::size_t slot) {
+      return table.MemoryAge(slot) < 0
+                 ? std::nan("")
+                 : static_cast<double>((table.*column)(slot)) * 1024;
+    };
+  };
+  family("sysmonitor_process_proportional_memory_bytes",
+         "sysmonitor_process_proportional_memory_bytes", "gauge",
+         "Proportional set size of the process.",
+         memory(&ProcessTable::Pss));
+  family("sysmonitor_process_unique_memory_bytes",
+         "sysmonitor_process_unique_memory_bytes", "gauge",
+         "Memory mapped by the process only.", memory(&ProcessTable::Uss));
+  family("sysmonitor_process_swap_bytes", "sysmonitor_process_swap_bytes",
+         "gauge", "Memory of the process swapped out.",
+         memory(&ProcessTable::Swap));
+  family("sysmonitor_process_anonymous_memory_bytes",
+         "sysmonitor_process_anonymous_memory_bytes", "gauge",
+         "Proportional set size of the anonymous memory of the process.",
+         memory(&ProcessTable::PssAnon));
+  family("sysmonitor_process_file_memory_bytes",
+         "sysmonitor_process_file_memory_bytes", "gauge",
+         "Proportional set size of the file backed memory of the process.",
+         memory(&ProcessTable::PssFile));
+  family("sysmonitor_process_memory_age_seconds",
+         "sysmonitor_process_memory_age_seconds", "gauge",
+         "Time since the memory breakdown of the process was read.",
+         [&](std::size_t slot) {
+           double age = table.MemoryAge(slot);
+           return age < 0 ? std::nan("") : age;
+         });
+  family("sysmonitor_process_read_bytes", "sysmonitor_process_read_bytes_total",
+         "counter", "Bytes the process read from storage.",
+         [&](std::size_t slot) { return table.ReadBytes(slot); });
+  family("sysmonitor_process_written_bytes",
+         "sysmonitor_process_written_bytes_total", "counter",
+         "Bytes the process wrote to storage.",
+         [&](std::size_t slot) { return table.WriteBytes(slot); });
+  family("sysmonitor_process_run_delay_seconds",
+         "sysmonitor_process_run_delay_seconds_total", "counter",
+         "Time the process waited on a run queue.", [&](std::size_t slot) {
+           return static_cast<double>(table.WaitTime(slot)) / 1e9;
+         });
+  body.append("# EOF\n");
+}
+
+/**
+ * @brief Accept scrapes until the exporter is stopped
+ *
+ * Scrapes are answered one at a time: each one only sends a buffer.
+ */
+void Exporter::Serve() {
+  pollfd listener{this->listen_fd, POLLIN, 0};
+  while (this->running) {
+    if (poll(&listener, 1, 250) <= 0) {
+      continue;
+    }
+    int fd = accept4(this->listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd >= 0) {
+      this->Respond(fd);
+      close(fd);
+    }
+  }
+}
+
+/**
+ * @brief Answer one scrape with the last rendered response
+ *
+ * @param fd connected socket
+ */
+void Exporter::Respond(int fd) {
+  // a client that does not send, or does not read, is dropped
+  timeval timeout{0, 0};
+  timeout.tv_usec = static_cast<suseconds_t>(
+      std::chrono::microseconds(kRequestTimeout).count());
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  auto deadline = std::chrono::steady_clock::now() + kResponseTimeout;
+
+  // consume the request up to the end of its headers; whatever the path,
+  // the metrics are returned
+  char request[1024];
+  std::size_t length{0};
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto count = recv(fd, request + length, sizeof(request) - length, 0);
+    if (count <= 0) {
+      break;
+    }
+    length += static_cast<std::size_t>(count);
+    if (std::string_view(request, length).find("\r\n\r\n") !=
+        std::string_view::npos) {
+      break;
+    }
+    // keep what may be the start of the terminator
+    if (length > 3) {
+      std::memmove(request, request + length - 3, 3);
+      length = 3;
+    }
+  }
+
+  std::shared_ptr<std::string> response;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    response = this->response;
+  }
+
+  static const std::string unavailable{
+      "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n"
+      "Connection: close\r\n\r\n"};
+  std::string const& data = response ? *response : unavailable;
+  std::size_t sent{0};
+  while (sent < data.size() && std::chrono::steady_clock::now() < deadline) {
+    auto count =
+        send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (count <= 0) {
+      break;
+    }
+    sent += static_cast<std::size_t>(count);
+  }
+
+  // drop the copy under the mutex, so Publish() sees it released only once
+  // the last send is done
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    response.reset();
+  }
+
+  // closing with unread bytes would reset the connection and could discard
+  // the response: wait for the client to close its side first
+  shutdown(fd, SHUT_WR);
+  while (std::chrono::steady_clock::now() < deadline &&
+         recv(fd, request, sizeof(request), 0) > 0) {
+  }
+}
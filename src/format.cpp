@@ -1,7 +1,7 @@
 #include "format.h"
 
 #include <chrono>
-#include <iomanip>
+#include <cstdio>
 #include <string>
 
 /**
@@ -28,14 +28,13 @@ std::string Format::ElapsedTime(long s) {
   // set seconds as remaining seconds
   seconds -= std::chrono::duration_cast<std::chrono::seconds>(minutes);
 
-  // build time string stream
-  std::stringstream ss{};
-  ss << std::setw(2) << std::setfill('0') << hours.count()     // HH
-     << std::setw(1) << ":"                                    // :
-     << std::setw(2) << std::setfill('0') << minutes.count()   // MM
-     << std::setw(1) << ":"                                    // :
-     << std::setw(2) << std::setfill('0') << seconds.count();  // SS
+  // build time string: HH:MM:SS is short enough not to allocate
+  char time[32];
+  int length = std::snprintf(time, sizeof(time), "%02ld:%02ld:%02ld",
+                             static_cast<long>(hours.count()),
+                             static_cast<long>(minutes.count()),
+                             static_cast<long>(seconds.count()));
 
   // return formated time
-  return ss.str();
+  return std::string(time, length);
 }
\ No newline at end of file
@@ -1,14 +1,69 @@
 #include "linux_parser.h"
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
 #include <filesystem>
 #include <iostream>
-#include <set>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// memory of the temporaries used while reading and parsing files
+static std::pmr::memory_resource* scratch{std::pmr::new_delete_resource()};
+
+/**
+ * @brief Split the next token (separated by spaces or tabs) off a line
+ *
+ * @param line remaining part of the line, the token is removed from it
+ * @return token, empty at the end of the line
+ */
+std::string_view nextToken(std::string_view& line) {
+  auto begin = line.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    line = {};
+    return {};
+  }
+  auto end = line.find_first_of(" \t", begin);
+  auto token = line.substr(begin, end - begin);
+  line.remove_prefix(end == std::string_view::npos ? line.size() : end);
+  return token;
+}
+
+/**
+ * @brief Split the next line off a file content
+ *
+ * @param content remaining content, the line is removed from it
+ * @return line, without its newline
+ */
+std::string_view nextLine(std::string_view& content) {
+  auto end = content.find('\n');
+  auto line = content.substr(0, end);
+  content.remove_prefix(end == std::string_view::npos ? content.size()
+                                                      : end + 1);
+  return line;
+}
+
+/**
+ * @brief Parse a number token
+ *
+ * @tparam T
+ * @param token
+ * @param value destination, untouched if token is not a number
+ * @return true if token is a number
+ */
+template <typename T>
+bool parseValue(std::string_view token, T& value) {
+  auto result = std::from_chars(token.data(), token.data() + token.size(),
+                                value);
+  return result.ec == std::errc();
+}
+
 /**
  * @brief Fetch a value by key in system's file.
  *
@@ -19,28 +74,110 @@
  */
 template <typename T>
 T findValueByKey(std::string const& keyFilter, std::string const& filename) {
-  T value;
-  std::string line;
-  std::string key;
-  std::ifstream stream(LinuxParser::kProcDirectory + filename);
-  if (stream.is_open()) {
-    // loop through file lines
-    while (std::getline(stream, line)) {
-      std::istringstream lstream(line);
-      while (lstream >> key >> value) {
-        // key found: return key's value
-        if (key == keyFilter) {
-          return value;
-        }
-      }
+  T value{};
+  std::pmr::string content(scratch);
+  if (!LinuxParser::ReadFile(LinuxParser::Path(filename), content)) {
+    return value;
+  }
+
+  // loop through file lines
+  std::string_view rest(content);
+  while (!rest.empty()) {
+    auto line = nextLine(rest);
+    // key found: return key's value
+    if (nextToken(line) == keyFilter) {
+      parseValue(nextToken(line), value);
+      return value;
     }
   }
-  stream.close();
 
   // key not found
   return value;
 };
 
+/**
+ * @brief Use a memory resource for the temporaries of the parser
+ *
+ * Meant for a per-tick arena; the parser then only allocates from it.
+ * The resource must outlive its use and is not synchronized, so the parser
+ * must be used from a single thread while it is set.
+ *
+ * @param resource memory resource, nullptr for the default heap
+ */
+void LinuxParser::ScratchResource(std::pmr::memory_resource* resource) {
+  scratch = resource != nullptr ? resource : std::pmr::new_delete_resource();
+}
+
+/**
+ * @brief Return the memory resource used for the temporaries of the parser
+ *
+ * @return std::pmr::memory_resource*
+ */
+std::pmr::memory_resource* LinuxParser::ScratchResource() { return scratch; }
+
+/**
+ * @brief Build the path of a file in /proc, in scratch memory
+ *
+ * @param filename file name relative to /proc
+ * @return std::pmr::string
+ */
+std::pmr::string LinuxParser::Path(std::string const& filename) {
+  std::pmr::string path(scratch);
+  path.reserve(kProcDirectory.size() + filename.size());
+  path.append(kProcDirectory).append(filename);
+  return path;
+}
+
+/**
+ * @brief Build the path of a file of a process, in scratch memory
+ *
+ * @param pid process PID
+ * @param filename file name relative to /proc/<pid>, with its leading slash
+ * @return std::pmr::string
+ */
+std::pmr::string LinuxParser::Path(long pid, std::string const& filename) {
+  char digits[24];
+  auto end = std::to_chars(digits, digits + sizeof(digits), pid).ptr;
+  std::pmr::string path(scratch);
+  path.reserve(kProcDirectory.size() + (end - digits) + filename.size());
+  path.append(kProcDirectory).append(digits, end).append(filename);
+  return path;
+}
+
+/**
+ * @brief Read a whole file
+ *
+ * Files in /proc report a size of zero, so they are read until the end.
+ * The capacity of content is reused, so reading many files through the same
+ * string only allocates for the largest one.
+ *
+ * @param path file path
+ * @param content destination of the file content
+ * @return true if the file was read
+ */
+bool LinuxParser::ReadFile(std::pmr::string const& path,
+                           std::pmr::string& content) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  content.clear();
+  std::size_t size{0};
+  while (true) {
+    if (content.size() < size + 1024) {
+      content.resize(std::max<std::size_t>(content.capacity(), size + 4096));
+    }
+    auto count = read(fd, content.data() + size, content.size() - size);
+    if (count <= 0) {
+      content.resize(size);
+      close(fd);
+      return count == 0;
+    }
+    size += static_cast<std::size_t>(count);
+  }
+}
+
 // Read OS data
 std::string LinuxParser::OperatingSystem() {
   std::string line;
@@ -86,26 +223,72 @@ std::string LinuxParser::Kernel() {
 }
 
 /**
- * @brief Get set of pids.
+ * @brief Replace the content of a vector with the numeric entries of a
+ * directory, in directory order
  *
- * @return std::vector<long>
+ * @param path directory such as /proc or /proc/<pid>/task
+ * @param ids destination, its capacity is reused
  */
-std::set<long> LinuxParser::Pids() {
-  std::set<long> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
+void listIds(std::string const& path, std::vector<long>& ids) {
+  ids.clear();
+  DIR* directory = opendir(path.c_str());
+  if (directory == nullptr) {
+    return;
+  }
   struct dirent* file;
   while ((file = readdir(directory)) != nullptr) {
     if (file->d_type == DT_DIR) {
-      std::string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        pids.emplace(std::stoi(filename));
+      std::string_view filename(file->d_name);
+      long id;
+      auto result = std::from_chars(
+          filename.data(), filename.data() + filename.size(), id);
+      if (result.ec == std::errc() &&
+          result.ptr == filename.data() + filename.size()) {
+        ids.push_back(id);
       }
     }
   }
   closedir(directory);
+}
+
+/**
+ * @brief Get the pids currently present in /proc, in directory order.
+ *
+ * @return std::vector<long>
+ */
+std::vector<long> LinuxParser::Pids() {
+  std::vector<long> pids;
+  Pids(pids);
   return pids;
 }
 
+/**
+ * @brief Replace the content of a vector with the pids present in /proc
+ *
+ * @param pids destination, its capacity is reused
+ */
+void LinuxParser::Pids(std::vector<long>& pids) {
+  listIds(kProcDirectory, pids);
+}
+
+/**
+ * @brief Read and return the name of the executable of a process
+ *
+ * Unlike the command line, it cannot be rewritten by the process (only
+ * renamed with prctl) and kernel threads have one.
+ *
+ * @param pid process PID
+ * @return comm, up to 15 characters
+ */
+std::string LinuxParser::Comm(long pid) {
+  std::string comm;
+  std::ifstream stream(kProcDirectory + std::to_string(pid) + kCommFilename);
+  if (stream.is_open()) {
+    std::getline(stream, comm);
+  }
+  return comm;
+}
+
 /**
  * @brief Calculate the system memory utilization.
  *
@@ -121,16 +304,20 @@ float LinuxParser::MemoryUtilization() {
  *
  * @return system uptime in seconds
  */
-long LinuxParser::UpTime() {
-  std::string line;
-  long uptime;
-  std::ifstream stream(kProcDirectory + kUptimeFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream lstream(line);
-    lstream >> uptime;
+long LinuxParser::UpTime() { return static_cast<long>(UpTimeSeconds()); }
+
+/**
+ * @brief Read and return the system uptime, with its fractional part
+ *
+ * @return system uptime in seconds, to the hundredth
+ */
+double LinuxParser::UpTimeSeconds() {
+  double uptime{0};
+  std::pmr::string content(scratch);
+  if (ReadFile(Path(kUptimeFilename), content)) {
+    std::string_view line(content);
+    parseValue(nextToken(line), uptime);
   }
-  stream.close();
   return uptime;
 }
 
@@ -143,55 +330,6 @@ long LinuxParser::Jiffies() {
   return LinuxParser::ActiveJiffies() + LinuxParser::IdleJiffies();
 }
 
-/**
- * @brief Read and return the number of active jiffies for a PID
- *
- * @param pid process PID
- * @return active jiffies for a PID
- */
-long LinuxParser::ActiveJiffies(long pid) {
-  std::string line;
-  std::string value;
-  std::vector<std::string> values;
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream lstream(line);
-    while (lstream >> value) {
-      values.push_back(value);
-    }
-  }
-  stream.close();
-
-  // values cannot be accessed by index: return dummy value
-  if (values.size() < 17) {
-    return 1;
-  }
-
-  // CPU time spent in user code, measured in clock ticks
-  float utime(1);
-  if (std::all_of(values[13].begin(), values[13].end(), isdigit))
-    utime = std::stof(values[13]);
-
-  // CPU time spent in kernel code, measured in clock ticks
-  float stime(1);
-  if (std::all_of(values[14].begin(), values[14].end(), isdigit))
-    stime = std::stof(values[14]);
-
-  // waited-for children's CPU time spent in user code (in clock ticks)
-  float cutime(1);
-  if (std::all_of(values[15].begin(), values[15].end(), isdigit))
-    cutime = std::stof(values[15]);
-
-  // waited-for children's CPU time spent in kernel code (in clock ticks)
-  float cstime(1);
-  if (std::all_of(values[16].begin(), values[16].end(), isdigit))
-    cstime = std::stof(values[16]);
-
-  return static_cast<long>((utime + stime + cutime + cstime) /
-                           static_cast<float>(sysconf(_SC_CLK_TCK)));
-}
-
 /**
  * @brief Read and return the number of active jiffies for the system
  *
@@ -199,18 +337,9 @@ long LinuxParser::ActiveJiffies(long pid) {
  */
 long LinuxParser::ActiveJiffies() {
   auto jiffies = CpuUtilization();
-
-  // values cannot be accessed by index: return dummy value
-  if (jiffies.size() < 9) {
-    return 1;
-  }
-
-  return std::stol(jiffies[CPUStates::kUser_]) +
-         std::stol(jiffies[CPUStates::kNice_]) +
-         std::stol(jiffies[CPUStates::kSystem_]) +
-         std::stol(jiffies[CPUStates::kIRQ_]) +
-         std::stol(jiffies[CPUStates::kSoftIRQ_]) +
-         std::stol(jiffies[CPUStates::kSteal_]);
+  return jiffies[CPUStates::kUser_] + jiffies[CPUStates::kNice_] +
+         jiffies[CPUStates::kSystem_] + jiffies[CPUStates::kIRQ_] +
+         jiffies[CPUStates::kSoftIRQ_] + jiffies[CPUStates::kSteal_];
 }
 
 /**
@@ -220,36 +349,27 @@ long LinuxParser::ActiveJiffies() {
  */
 long LinuxParser::IdleJiffies() {
   auto jiffies = CpuUtilization();
-
-  // values cannot be accessed by index: return dummy value
-  if (jiffies.size() < 9) {
-    return 1;
-  }
-
-  return std::stol(jiffies[CPUStates::kIdle_]) +
-         std::stol(jiffies[CPUStates::kIOwait_]);
+  return jiffies[CPUStates::kIdle_] + jiffies[CPUStates::kIOwait_];
 }
 
 /**
- * @brief Read and return CPU utilization
+ * @brief Read and return the aggregate jiffies spent in each CPU state
+ *
+ * States missing from /proc/stat (on old kernels) are zero.
  *
- * @return std::vector<std::string>
+ * @return jiffies indexed by CPUStates
  */
-std::vector<std::string> LinuxParser::CpuUtilization() {
-  std::string line;
-  std::string value;
-  std::string cpu;
-  std::vector<std::string> cpuJiffies;
-  std::ifstream stream(kProcDirectory + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream lstream(line);
-    lstream >> cpu;
-    while (lstream >> value) {
-      cpuJiffies.push_back(value);
+std::array<long, LinuxParser::kGuestNice_ + 1> LinuxParser::CpuUtilization() {
+  std::array<long, kGuestNice_ + 1> cpuJiffies{};
+  std::pmr::string content(scratch);
+  if (ReadFile(Path(kStatFilename), content)) {
+    std::string_view rest(content);
+    auto line = nextLine(rest);
+    nextToken(line);  // cpu
+    for (auto& jiffies : cpuJiffies) {
+      parseValue(nextToken(line), jiffies);
     }
   }
-  stream.close();
   return cpuJiffies;
 }
 
@@ -271,6 +391,139 @@ long LinuxParser::RunningProcesses() {
   return findValueByKey<long>(fRunningProcesses, kStatFilename);
 }
 
+/**
+ * @brief Read the storage I/O counters of a process, through a reusable
+ * buffer
+ *
+ * /proc/<pid>/io is only readable for processes we may ptrace, so this
+ * fails for everything else.
+ *
+ * @param pid process PID
+ * @param io destination of the parsed values
+ * @param content buffer for the file content
+ * @return true if the file was read
+ */
+bool LinuxParser::Io(long pid, ProcessIo& io, std::pmr::string& content) {
+  if (!ReadFile(Path(pid, kIoFilename), content)) {
+    return false;
+  }
+  io = ParseIo(content);
+  return true;
+}
+
+/**
+ * @brief Parse the content of /proc/<pid>/io
+ *
+ * @param content file content
+ * @return bytes read from and written to storage
+ */
+LinuxParser::ProcessIo LinuxParser::ParseIo(std::string_view content) {
+  ProcessIo io;
+  std::string_view rest(content);
+  while (!rest.empty()) {
+    auto line = nextLine(rest);
+    auto key = nextToken(line);
+    if (key == fReadBytes) {
+      parseValue(nextToken(line), io.read_bytes);
+    } else if (key == fWriteBytes) {
+      parseValue(nextToken(line), io.write_bytes);
+      break;
+    }
+  }
+  return io;
+}
+
+/**
+ * @brief Read the scheduler statistics of a process, through a reusable
+ * buffer
+ *
+ * These are the statistics of the main thread; the file stays zero on
+ * kernels built without CONFIG_SCHED_INFO.
+ *
+ * @param pid process PID
+ * @param schedstat destination of the parsed values
+ * @param content buffer for the file content
+ * @return true if the file was read
+ */
+bool LinuxParser::Schedstat(long pid, ProcessSchedstat& schedstat,
+                            std::pmr::string& content) {
+  if (!ReadFile(Path(pid, kSchedstatFilename), content)) {
+    return false;
+  }
+  schedstat = ParseSchedstat(content);
+  return true;
+}
+
+/**
+ * @brief Parse the content of /proc/<pid>/schedstat
+ *
+ * @param content file content
+ * @return time on CPU, time waiting on a run queue and timeslices
+ */
+LinuxParser::ProcessSchedstat LinuxParser::ParseSchedstat(
+    std::string_view content) {
+  ProcessSchedstat schedstat;
+  auto line = nextLine(content);
+  parseValue(nextToken(line), schedstat.run_time);
+  parseValue(nextToken(line), schedstat.wait_time);
+  parseValue(nextToken(line), schedstat.timeslices);
+  return schedstat;
+}
+
+/**
+ * @brief Read the memory breakdown of a process, through a reusable buffer
+ *
+ * The kernel walks every mapping of the process to produce smaps_rollup,
+ * so this is much more expensive than reading stat; it also fails for the
+ * processes of other users unless the monitor may ptrace them.
+ *
+ * @param pid process PID
+ * @param memory destination of the parsed values
+ * @param content buffer for the file content
+ * @return true if the file was read
+ */
+bool LinuxParser::Memory(long pid, ProcessMemory& memory,
+                         std::pmr::string& content) {
+  if (!ReadFile(Path(pid, kSmapsRollupFilename), content)) {
+    return false;
+  }
+  memory = ParseMemory(content);
+  return true;
+}
+
+/**
+ * @brief Parse the content of /proc/<pid>/smaps_rollup
+ *
+ * @param content file content
+ * @return proportional, private and swapped memory (in kB)
+ */
+LinuxParser::ProcessMemory LinuxParser::ParseMemory(std::string_view content) {
+  ProcessMemory memory;
+  std::string_view rest(content);
+  nextLine(rest);  // address range of the rollup
+  while (!rest.empty()) {
+    auto line = nextLine(rest);
+    auto key = nextToken(line);
+    auto value = nextToken(line);
+    if (key == fPss) {
+      parseValue(value, memory.pss);
+    } else if (key == fPssAnon) {
+      parseValue(value, memory.pss_anon);
+    } else if (key == fPssFile) {
+      parseValue(value, memory.pss_file);
+    } else if (key == fPssShmem) {
+      parseValue(value, memory.pss_shmem);
+    } else if (key == fPrivateClean) {
+      parseValue(value, memory.private_clean);
+    } else if (key == fPrivateDirty) {
+      parseValue(value, memory.private_dirty);
+    } else if (key == fSwap) {
+      parseValue(value, memory.swap);
+    }
+  }
+  return memory;
+}
+
 /**
  * @brief Read and return the command associated with a process
  *
@@ -288,91 +541,61 @@ std::string LinuxParser::Command(long pid) {
 }
 
 /**
- * @brief Read and return the memory used by a process
+ * @brief Read and return the user ID associated with a process
+ *
+ * The owner of /proc/<pid> cannot be used: it is root for the processes
+ * that are not dumpable, whatever their user.
  *
  * @param pid process PID
- * @return memory used by a process
+ * @return real user ID of the process, -1 if it exited
  */
-std::string LinuxParser::Ram(long pid) {
-  std::string line;
-  std::string key;
-  double memory(0);
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatusFilename);
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::istringstream lstream(line);
-      lstream >> key;
-      if (key == fProcMem) {
-        lstream >> memory;
-        memory /= 1024.0;
-        break;
-      }
-    }
+long LinuxParser::Uid(long pid) {
+  std::pmr::string content(scratch);
+  if (!ReadFile(Path(pid, kStatusFilename), content)) {
+    return -1;
   }
-  stream.close();
-  return std::to_string(memory).substr(0, 7);
+  return ParseUid(content);
 }
 
 /**
- * @brief Read and return the user ID associated with a process
+ * @brief Parse the real user ID out of the content of /proc/<pid>/status
  *
- * @param pid process PID
- * @return user ID associated with a process
+ * @param content file content
+ * @return real user ID, -1 if the Uid line is missing
  */
-std::string LinuxParser::Uid(long pid) {
-  return findValueByKey<std::string>(fUID, std::to_string(pid) + kStatFilename);
+long LinuxParser::ParseUid(std::string_view content) {
+  std::string_view rest(content);
+  while (!rest.empty()) {
+    auto line = nextLine(rest);
+    if (nextToken(line) == fUID) {
+      long uid;
+      return parseValue(nextToken(line), uid) ? uid : -1;
+    }
+  }
+  return -1;
 }
 
 /**
- * @brief Read and return the user associated with a process
+ * @brief Read and return the users of the system
  *
- * @param pid process PID
- * @return user associated with a process
+ * @return user IDs and names
  */
-std::string LinuxParser::User(long pid) {
-  std::string id;
-  std::string x;
+std::vector<std::pair<long, std::string>> LinuxParser::Users() {
+  std::vector<std::pair<long, std::string>> users;
   std::string user;
+  std::string x;
+  long id;
   std::string line;
   std::ifstream stream(kPasswordPath);
   if (stream.is_open()) {
     while (std::getline(stream, line)) {
       std::replace(line.begin(), line.end(), ':', ' ');
       std::istringstream lstream(line);
-      lstream >> user >> x >> id;
-      if (id == Uid(pid)) {
-        break;
+      if (lstream >> user >> x >> id) {
+        users.emplace_back(id, user);
       }
     }
   }
   stream.close();
-  return user;
-}
-
-/**
- * @brief Read and return the uptime of a process
- *
- * @param pid process PID
- * @return uptime of a process
- */
-long LinuxParser::UpTime(long pid) {
-  std::string line;
-  std::string value;
-  std::vector<std::string> values;
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream lstream(line);
-    while (lstream >> value) {
-      values.push_back(value);
-    }
-  }
-  stream.close();
-
-  // values cannot be accessed by index: return dummy value
-  if (values.size() < 22) {
-    return 1.0;
-  }
-
-  return std::stof(values[21]) / static_cast<float>(sysconf(_SC_CLK_TCK));
+  return users;
 }
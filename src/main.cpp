@@ -1,7 +1,139 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "exporter.h"
 #include "ncurses_display.h"
 #include "system.h"
+#include "watcher.h"
+
+// largest ring of samples per watched process, and processes exported
+const std::size_t kMaxCapacity{1 << 20};
+const std::size_t kMaxTop{1 << 16};
+
+/**
+ * @brief Parse a count, rejecting the negative values std::stoul wraps around
+ *
+ * @param value option value
+ * @param max largest count accepted
+ * @return std::size_t
+ */
+std::size_t ParseCount(std::string const& value, std::size_t max) {
+  long count = std::stol(value);
+  if (count < 0 || static_cast<std::size_t>(count) > max) {
+    throw std::out_of_range(value);
+  }
+  return static_cast<std::size_t>(count);
+}
+
+/**
+ * @brief Parse the command line options
+ *
+ * --watch <pid,pid,...|pattern> [--interval <ms>] [--window <ms>]
+ * [--capacity <samples>]
+ * [--metrics-port <port> | --metrics-socket <path>] [--metrics-top <n>]
+ * [--backend <sync|io_uring>] [--memory-budget <ms>]
+ *
+ * @param args command line arguments, without the program name
+ * @param watch parsed options of watch mode
+ * @param exporter parsed options of the metrics exporter
+ * @param backend how the per-process files are read
+ * @param memory_budget time the memory breakdown may take per refresh
+ * @return true if the arguments are valid
+ */
+bool ParseOptions(std::vector<std::string> const& args, WatchOptions& watch,
+                  ExporterOptions& exporter, std::string& backend,
+                  std::chrono::milliseconds& memory_budget) {
+  for (std::size_t i = 0; i + 1 < args.size(); i += 2) {
+    std::string const& value = args[i + 1];
+    try {
+      if (args[i] == "--watch") {
+        if (std::all_of(value.begin(), value.end(),
+                        [](char c) { return isdigit(c) || c == ','; })) {
+          std::istringstream stream(value);
+          std::string pid;
+          while (std::getline(stream, pid, ',')) {
+            if (!pid.empty()) watch.pids.push_back(std::stol(pid));
+          }
+        } else {
+          std::regex check(value);  // an invalid pattern throws here
+          watch.pattern = value;
+        }
+      } else if (args[i] == "--interval") {
+        watch.interval = std::chrono::milliseconds(std::stol(value));
+      } else if (args[i] == "--window") {
+        watch.window = std::chrono::milliseconds(std::stol(value));
+      } else if (args[i] == "--capacity") {
+        watch.capacity = ParseCount(value, kMaxCapacity);
+      } else if (args[i] == "--metrics-port") {
+        exporter.port = std::stoi(value);
+      } else if (args[i] == "--metrics-socket") {
+        exporter.socket_path = value;
+      } else if (args[i] == "--metrics-top") {
+        exporter.top = ParseCount(value, kMaxTop);
+      } else if (args[i] == "--backend") {
+        backend = value;
+      } else if (args[i] == "--memory-budget") {
+        memory_budget = std::chrono::milliseconds(std::stol(value));
+      } else {
+        return false;
+      }
+    } catch (...) {
+      return false;
+    }
+  }
+  return args.size() % 2 == 0 && watch.interval.count() > 0 &&
+         watch.window.count() > 0 && watch.capacity > 0 &&
+         exporter.port >= 0 && exporter.port < 65536 &&
+         (backend == "sync" || backend == "io_uring") &&
+         memory_budget.count() >= 0;
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> args(argv + 1, argv + argc);
+  WatchOptions watch;
+  ExporterOptions metrics;
+  std::string backend{"sync"};
+  std::chrono::milliseconds memory_budget{5};
+  if (!ParseOptions(args, watch, metrics, backend, memory_budget)) {
+    std::cerr << "usage: " << argv[0]
+              << " [--watch <pid,pid,...|pattern> [--interval <ms>]"
+                 " [--window <ms>] [--capacity <samples>]]\n"
+                 "       [--metrics-port <port> | --metrics-socket <path>]"
+                 " [--metrics-top <n>]\n"
+                 "       [--backend <sync|io_uring>]"
+                 " [--memory-budget <ms>]\n";
+    return 1;
+  }
+
+  if (!watch.pids.empty() || !watch.pattern.empty()) {
+    return Watcher(watch).Run();
+  }
+
+  std::unique_ptr<Exporter> exporter;
+  if (metrics.port != 0 || !metrics.socket_path.empty()) {
+    exporter = std::make_unique<Exporter>(metrics);
+    std::string error;
+    if (!exporter->Start(error)) {
+      std::cerr << "metrics: " << error << "\n";
+      return 1;
+    }
+  }
 
-int main() {
   System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+  if (backend == "io_uring" && !system.Table().UseIoUring()) {
+    std::cerr << "io_uring is unavailable, reading /proc synchronously\n";
+  }
+  // the displayed and exported rows get their memory breakdown every refresh
+  int rows{20};
+  system.Table().MemoryBudget(
+      std::max<std::size_t>(rows, exporter ? metrics.top : 0), memory_budget);
+  NCursesDisplay::Display(system, rows, exporter.get());
+}
@@ -2,118 +2,174 @@
 
 #include <curses.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <memory_resource>
 #include <string>
-#include <thread>
+#include <string_view>
 #include <vector>
 
+#include "exporter.h"
 #include "format.h"
 #include "system.h"
 
-using std::string;
-using std::to_string;
-
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
-std::string NCursesDisplay::ProgressBar(float percent) {
-  std::string result{"0%"};
+std::pmr::string NCursesDisplay::ProgressBar(
+    float percent, std::pmr::memory_resource* resource) {
   int size{50};
   float bars{percent * size};
+  std::pmr::string result(resource);
+  result.reserve(size + 16);
+  result.append("0%");
 
   for (int i{0}; i < size; ++i) {
     result += i <= bars ? '|' : ' ';
   }
 
-  string display{to_string(percent * 100).substr(0, 4)};
-  if (percent < 0.1 || percent == 1.0)
-    display = " " + to_string(percent * 100).substr(0, 3);
-  return result + " " + display + "/100%";
+  char display[16];
+  std::snprintf(display, sizeof(display), " %4.1f/100%%", percent * 100);
+  return result.append(display);
 }
 
 void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
   int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
+  mvwprintw(window, ++row, 2, "OS: %s", system.OperatingSystem().c_str());
+  mvwprintw(window, ++row, 2, "Kernel: %s", system.Kernel().c_str());
   mvwprintw(window, ++row, 2, "CPU: ");
   wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
+  mvwprintw(window, row, 10, "%s",
+            ProgressBar(system.CpuUtilization(), system.Arena()).c_str());
   wattroff(window, COLOR_PAIR(1));
   mvwprintw(window, ++row, 2, "Memory: ");
   wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
+  mvwprintw(window, row, 10, "%s",
+            ProgressBar(system.MemoryUtilization(), system.Arena()).c_str());
   wattroff(window, COLOR_PAIR(1));
   mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(
-      window, ++row, 2,
-      ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
-            ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
+            "PSS: %10.1f MB  (%zu/%zu processes, oldest %.0f s)   ",
+            system.ProportionalMemory(), system.Table().MemoryCovered(),
+            system.Processes().size(), system.Table().OldestMemoryAge());
+  mvwprintw(window, ++row, 2, "Total Processes: %-10ld",
+            system.TotalProcesses());
+  mvwprintw(window, ++row, 2, "Running Processes: %-10ld",
+            system.RunningProcesses());
+  mvwprintw(window, ++row, 2, "Run Delay: %8.1f ms  (%4.1f%% of runnable time)",
+            system.RunDelay(), system.WaitRatio() * 100);
+  mvwprintw(window, ++row, 2, "Up Time: %s",
+            Format::ElapsedTime(system.UpTime()).c_str());
   wrefresh(window);
 }
 
-void NCursesDisplay::DisplayProcesses(std::set<Process>& processes,
-                                      WINDOW* window, int n) {
+void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
+                                      WINDOW* window, int n,
+                                      ProcessTable::SortKey key) {
   int row{0};
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
-  int const ram_column{26};
-  int const time_column{35};
-  int const command_column{46};
+  int const delay_column{25};
+  int const pss_column{36};
+  int const uss_column{45};
+  int const age_column{54};
+  int const time_column{59};
+  int const command_column{70};
+  int const command_width{std::max(window->_maxx - command_column, 0)};
   wattron(window, COLOR_PAIR(2));
   mvwprintw(window, ++row, pid_column, "PID");
   mvwprintw(window, row, user_column, "USER");
-  mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
+  // the sort column is marked with a trailing *
+  mvwprintw(window, row, cpu_column, "CPU[%%]%c",
+            key == ProcessTable::SortKey::kCpu ? '*' : ' ');
+  mvwprintw(window, row, delay_column, "DELAY[ms]%c",
+            key == ProcessTable::SortKey::kRunDelay ? '*' : ' ');
+  mvwprintw(window, row, pss_column, "PSS[MB]");
+  mvwprintw(window, row, uss_column, "USS[MB]");
+  mvwprintw(window, row, age_column, "AGE");
   mvwprintw(window, row, time_column, "TIME+");
   mvwprintw(window, row, command_column, "COMMAND");
   wattroff(window, COLOR_PAIR(2));
-  for (auto p : processes) {
-    mvwprintw(window, ++row, pid_column, to_string(p.Pid()).c_str());
-    mvwprintw(window, row, user_column, p.User().c_str());
-    float cpu = p.CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, p.Ram().c_str());
-    mvwprintw(window, row, time_column,
+  for (auto const& p : processes) {
+    // fixed widths overwrite whatever the previous frame left in the row
+    mvwprintw(window, ++row, pid_column, "%-6ld", p.Pid());
+    auto user = p.User();
+    mvwprintw(window, row, user_column, "%-6.*s",
+              static_cast<int>(std::min<std::size_t>(user.size(), 6)),
+              user.data());
+    mvwprintw(window, row, cpu_column, "%-9.1f", p.CpuUtilization() * 100);
+    mvwprintw(window, row, delay_column, "%-11.1f", p.RunDelay());
+    // the memory breakdown is not read every tick, its age tells how stale
+    double age = p.MemoryAge();
+    if (age < 0) {
+      mvwprintw(window, row, pss_column, "%-8s", "-");
+      mvwprintw(window, row, uss_column, "%-8s", "-");
+      mvwprintw(window, row, age_column, "%-4s", "-");
+    } else {
+      mvwprintw(window, row, pss_column, "%-8.1f", p.Pss());
+      mvwprintw(window, row, uss_column, "%-8.1f", p.Uss());
+      mvwprintw(window, row, age_column, "%-4.0f", age);
+    }
+    mvwprintw(window, row, time_column, "%-10s",
               Format::ElapsedTime(p.UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              p.Command().substr(0, window->_maxx - 46).c_str());
+    auto command = p.Command();
+    mvwprintw(window, row, command_column, "%-*.*s", command_width,
+              static_cast<int>(std::min<std::size_t>(
+                  command.size(), static_cast<std::size_t>(command_width))),
+              command.data());
     if (row == n + 1) {
       break;
     }
   }
 }
 
-void NCursesDisplay::Display(System& system, int n) {
+void NCursesDisplay::Display(System& system, int n, Exporter* exporter) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
   start_color();  // enable color
 
   int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
+  WINDOW* system_window = newwin(11, x_max - 1, 0, 0);
   WINDOW* process_window =
       newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
 
+  using Clock = std::chrono::steady_clock;
+  auto next = Clock::now();
   while (1) {
-    try {
-      system.updateProcesses();
-    } catch (...) {
-      continue;
+    // a key only redraws the snapshot: the rates keep a full period
+    if (Clock::now() >= next) {
+      next = Clock::now() + std::chrono::seconds(1);
+      try {
+        system.update();
+      } catch (...) {
+        continue;
+      }
+      if (exporter != nullptr) {
+        exporter->Publish(system);
+      }
     }
     init_pair(1, COLOR_BLUE, COLOR_BLACK);
     init_pair(2, COLOR_GREEN, COLOR_BLACK);
     box(system_window, 0, 0);
     box(process_window, 0, 0);
     DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
+    DisplayProcesses(system.Processes(), process_window, n,
+                     system.Table().SortedBy());
     wrefresh(system_window);
     wrefresh(process_window);
     refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    // wait for a key until the next refresh; 'c' sorts the processes by CPU
+    // utilization, 'd' by run delay
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next - Clock::now());
+    timeout(static_cast<int>(std::max<long>(wait.count(), 0)));
+    int key = getch();
+    if (key == 'c') {
+      system.SortBy(ProcessTable::SortKey::kCpu);
+    } else if (key == 'd') {
+      system.SortBy(ProcessTable::SortKey::kRunDelay);
+    }
   }
   endwin();
 }
\ No newline at end of file
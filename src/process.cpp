@@ -2,23 +2,34 @@
 
 #include <unistd.h>
 
-#include <string>
+#include <string_view>
 
-#include "linux_parser.h"
+#include "process_table.h"
 
 /**
  * @brief Construct a new Process:: Process object
  *
- * @param pid
+ * @param table table holding the process data
+ * @param handle handle of the process in the table
  */
-Process::Process(long pid) : pid(pid) {}
+Process::Process(ProcessTable const& table, ProcessTable::Handle handle)
+    : table(&table), handle(handle) {}
+
+/**
+ * @brief Check that the process is still the one in its table slot
+ *
+ * @return true if the attributes are the process's
+ */
+bool Process::Valid() const { return this->table->Valid(this->handle); }
 
 /**
  * @brief Return this process's ID
  *
  * @return int
  */
-long Process::Pid() const { return this->pid; }
+long Process::Pid() const {
+  return this->Valid() ? this->table->Pid(this->handle.slot) : 0;
+}
 
 /**
  * @brief Return this process's CPU utilization
@@ -26,51 +37,97 @@ long Process::Pid() const { return this->pid; }
  * @return float
  */
 float Process::CpuUtilization() const {
-  try {
-    return static_cast<float>(LinuxParser::ActiveJiffies(this->pid)) /
-           static_cast<float>(this->UpTime());
-  } catch (...) {
-    return 1.0;
-  }
+  return this->Valid() ? this->table->CpuUtilization(this->handle.slot) : 0;
+}
+
+/**
+ * @brief Return the time this process waited on a run queue during the last
+ * interval (in milliseconds)
+ *
+ * @return float
+ */
+float Process::RunDelay() const {
+  return this->Valid() ? this->table->RunDelay(this->handle.slot) : 0;
+}
+
+/**
+ * @brief Return the share of its runnable time this process spent waiting on
+ * a run queue during the last interval
+ *
+ * @return float
+ */
+float Process::WaitRatio() const {
+  return this->Valid() ? this->table->WaitRatio(this->handle.slot) : 0;
 }
 
 /**
  * @brief Return the command that generated this process
  *
- * @return std::string
+ * @return std::string_view
  */
-std::string Process::Command() const { return LinuxParser::Command(this->pid); }
+std::string_view Process::Command() const {
+  return this->Valid() ? this->table->Command(this->handle.slot)
+                       : std::string_view();
+}
 
 /**
- * @brief Return this process's memory utilization
+ * @brief Return this process's memory utilization (in megabytes)
  *
- * @return std::string
+ * @return double
  */
-std::string Process::Ram() const { return LinuxParser::Ram(this->pid); }
+double Process::Ram() const {
+  return this->Valid() ? this->table->RamMegabytes(this->handle.slot) : 0;
+}
 
 /**
- * @brief Return the user (name) that generated this process
+ * @brief Return this process's proportional share of memory (in megabytes)
  *
- * @return std::string
+ * @return double
  */
-std::string Process::User() const { return LinuxParser::User(this->pid); }
+double Process::Pss() const {
+  if (!this->Valid()) {
+    return 0;
+  }
+  return static_cast<double>(this->table->Pss(this->handle.slot)) / 1024.0;
+}
 
 /**
- * @brief Return the age of this process (in seconds)
+ * @brief Return the memory only this process maps (in megabytes)
  *
- * @return long
+ * @return double
  */
-long Process::UpTime() const {
-  return LinuxParser::UpTime() - LinuxParser::UpTime(this->pid);
+double Process::Uss() const {
+  if (!this->Valid()) {
+    return 0;
+  }
+  return static_cast<double>(this->table->Uss(this->handle.slot)) / 1024.0;
+}
+
+/**
+ * @brief Return the age of Pss() and Uss() (in seconds), or -1 if they were
+ * never read
+ *
+ * @return double
+ */
+double Process::MemoryAge() const {
+  return this->Valid() ? this->table->MemoryAge(this->handle.slot) : -1;
+}
+
+/**
+ * @brief Return the user (name) that generated this process
+ *
+ * @return std::string_view
+ */
+std::string_view Process::User() const {
+  return this->Valid() ? this->table->User(this->handle.slot)
+                       : std::string_view();
 }
 
 /**
- * @brief Overload the "less than" comparison operator for Process objects
+ * @brief Return the age of this process (in seconds)
  *
- * @param a
- * @return true
- * @return false
+ * @return long
  */
-bool Process::operator<(Process const& o) const {
-  return CpuUtilization() > o.CpuUtilization();
+long Process::UpTime() const {
+  return this->Valid() ? this->table->UpTime(this->handle.slot) : 0;
 }
@@ -0,0 +1,704 @@
+#include "process_table.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_stat.h"
+#include "uring_reader.h"
+
+// pids per io_uring batch, and the files read for each of them
+const std::size_t kBatch{128};
+const std::size_t kFiles{3};
+const std::size_t kFileCapacity[kFiles]{1024, 512, 128};
+const std::size_t kPidCapacity{1024 + 512 + 128};
+
+/**
+ * @brief Hash the comm of a process, FNV-1a
+ *
+ * @param comm NUL terminated name
+ * @return std::uint32_t
+ */
+static std::uint32_t CommHash(std::array<char, 16> const& comm) {
+  std::uint32_t hash{2166136261u};
+  for (std::size_t i = 0; i < comm.size() && comm[i] != '\0'; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(comm[i])) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief Sample every process in /proc and refresh the derived columns
+ *
+ * Processes seen for the first time get a slot, processes that disappeared
+ * since the previous tick give theirs back to the free list.
+ */
+void ProcessTable::Update() {
+  auto now = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(now - this->sampled).count();
+  this->sampled = now;
+  // the fraction matters for the lifetime average of processes just started
+  this->uptime = LinuxParser::UpTimeSeconds();
+  ++this->tick;
+
+  // remember the counters of the previous sample for the rate computation
+  for (std::size_t i = 0; i < this->pids.size(); ++i) {
+    this->last_ticks[i] = this->utimes[i] + this->stimes[i];
+  }
+  for (std::size_t i = 0; i < this->pids.size(); ++i) {
+    this->last_run_times[i] = this->run_times[i];
+    this->last_wait_times[i] = this->wait_times[i];
+  }
+
+  // one buffer, in scratch memory, for every file read during the tick
+  std::pmr::string content(LinuxParser::ScratchResource());
+  LinuxParser::Pids(this->listing);
+  for (auto pid : this->listing) {
+    auto it = this->slots.find(pid);
+    std::uint32_t slot =
+        it == this->slots.end() ? this->Acquire(pid) : it->second;
+    if (this->uring) {
+      this->pending.push_back(slot);
+      if (this->pending.size() == kBatch) {
+        this->SampleBatch(content);
+      }
+    } else {
+      this->Sample(slot, content);
+    }
+  }
+  if (this->uring) {
+    this->SampleBatch(content);
+  }
+
+  // release slots of processes that exited (or could not be read)
+  for (std::uint32_t i = 0; i < this->pids.size(); ++i) {
+    if (this->pids[i] != 0 && this->seen[i] != this->tick) {
+      this->Release(i);
+    }
+  }
+
+  this->Rates(seconds);
+  this->Sort();
+  this->SampleMemory(content);
+}
+
+/**
+ * @brief Read the per-process files in batches through io_uring
+ *
+ * @return false if io_uring is not available, the table then keeps reading
+ * the files synchronously
+ */
+bool ProcessTable::UseIoUring() {
+  auto uring = std::make_unique<UringReader>(2 * kFiles * kBatch);
+  if (!uring->Available()) {
+    return false;
+  }
+
+  this->uring = std::move(uring);
+  this->pending.reserve(kBatch);
+  this->paths.resize(kFiles * kBatch);
+  this->requests.resize(kFiles * kBatch);
+  this->buffers.resize(kBatch * kPidCapacity);
+  for (std::size_t i = 0; i < kBatch; ++i) {
+    char* buffer = this->buffers.data() + i * kPidCapacity;
+    for (std::size_t file = 0; file < kFiles; ++file) {
+      this->requests[kFiles * i + file] = {
+          this->paths[kFiles * i + file].data(), buffer, kFileCapacity[file],
+          0};
+      buffer += kFileCapacity[file];
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Bound the smaps_rollup reads of a tick
+ *
+ * @param priority rows of the order read every tick, whatever the budget
+ * @param budget time the other processes may take per tick, round-robin
+ */
+void ProcessTable::MemoryBudget(std::size_t priority,
+                                std::chrono::microseconds budget) {
+  this->memory_priority = priority;
+  this->memory_budget = budget;
+}
+
+/**
+ * @brief Change the column the live slots are sorted by, and sort them again
+ *
+ * @param key
+ */
+void ProcessTable::SortBy(SortKey key) {
+  this->sort_key = key;
+  this->Sort();
+}
+
+/**
+ * @brief Return the live slots, sorted by descending CPU utilization
+ *
+ * @return std::vector<std::uint32_t> const&
+ */
+std::vector<std::uint32_t> const& ProcessTable::Order() const {
+  return this->order;
+}
+
+/**
+ * @brief Return a handle to the process currently in a slot
+ *
+ * @param slot live slot
+ * @return Handle
+ */
+ProcessTable::Handle ProcessTable::HandleOf(std::uint32_t slot) const {
+  return Handle{slot, this->generations[slot]};
+}
+
+/**
+ * @brief Check that a handle still refers to the process it was taken for
+ *
+ * @param handle
+ * @return true if the process did not exit, nor its slot get reused, since
+ */
+bool ProcessTable::Valid(Handle handle) const {
+  return handle.slot < this->generations.size() &&
+         this->generations[handle.slot] == handle.generation &&
+         this->pids[handle.slot] != 0;
+}
+
+/**
+ * @brief Return the number of processes being tracked
+ *
+ * @return std::size_t
+ */
+std::size_t ProcessTable::Size() const { return this->slots.size(); }
+
+/**
+ * @brief Estimate the memory held by the table
+ *
+ * Counts the reserved capacity of every column plus the hash map buckets and
+ * nodes (a node holds the pair, the next pointer and the cached hash).
+ * Interned strings are not counted.
+ *
+ * @return bytes
+ */
+std::size_t ProcessTable::Bytes() const {
+  return
+      this->pids.capacity() * sizeof(std::int32_t) +
+      this->generations.capacity() * sizeof(std::uint32_t) +
+      (this->seen.capacity() + this->scheduled.capacity()) *
+          sizeof(std::uint32_t) +
+      this->fresh.capacity() * sizeof(std::uint8_t) +
+      (this->start_times.capacity() + this->utimes.capacity() +
+       this->stimes.capacity() + this->last_ticks.capacity() +
+       this->rss.capacity() + this->read_bytes.capacity() +
+       this->write_bytes.capacity() + this->run_times.capacity() +
+       this->wait_times.capacity() + this->last_run_times.capacity() +
+       this->last_wait_times.capacity() + this->pss.capacity() +
+       this->uss.capacity() + this->swap.capacity() +
+       this->pss_anon.capacity() + this->pss_file.capacity()) *
+          sizeof(std::uint64_t) +
+      this->memory_times.capacity() *
+          sizeof(std::chrono::steady_clock::time_point) +
+      (this->cpu.capacity() + this->run_delays.capacity() +
+       this->wait_ratios.capacity()) *
+          sizeof(float) +
+      (this->commands.capacity() + this->users.capacity()) *
+          sizeof(StringPool::Id) +
+      (this->free_slots.capacity() + this->order.capacity() +
+       this->comm_hashes.capacity()) *
+          sizeof(std::uint32_t) +
+      this->slots.bucket_count() * sizeof(void*) +
+      this->slots.size() * (sizeof(std::pair<long const, std::uint32_t>) +
+                            sizeof(void*) + sizeof(std::size_t));
+}
+
+/**
+ * @brief Estimate the memory held by the table per tracked process
+ *
+ * @return bytes per tracked process, 0 if none is tracked
+ */
+std::size_t ProcessTable::BytesPerProcess() const {
+  return this->slots.empty() ? 0 : this->Bytes() / this->slots.size();
+}
+
+/**
+ * @brief Return the age of the process in a slot (in seconds)
+ *
+ * @param slot
+ * @return long
+ */
+long ProcessTable::UpTime(std::size_t slot) const {
+  static const double hz = static_cast<double>(sysconf(_SC_CLK_TCK));
+  return static_cast<long>(this->uptime -
+                           static_cast<double>(this->start_times[slot]) / hz);
+}
+
+/**
+ * @brief Return the resident set size of the process in a slot
+ *
+ * @param slot
+ * @return resident memory in megabytes
+ */
+double ProcessTable::RamMegabytes(std::size_t slot) const {
+  static const double page = static_cast<double>(sysconf(_SC_PAGESIZE));
+  return static_cast<double>(this->rss[slot]) * page / (1024.0 * 1024.0);
+}
+
+/**
+ * @brief Return the age of the memory breakdown of the process in a slot
+ *
+ * @param slot
+ * @return seconds since smaps_rollup was read, or -1 if it never was
+ */
+double ProcessTable::MemoryAge(std::size_t slot) const {
+  if (this->memory_times[slot] == std::chrono::steady_clock::time_point{}) {
+    return -1;
+  }
+  return std::chrono::duration<double>(this->sampled -
+                                       this->memory_times[slot])
+      .count();
+}
+
+/**
+ * @brief Take a slot from the free list (or grow the columns) for a pid
+ *
+ * @param pid process PID
+ * @return slot now owned by pid
+ */
+std::uint32_t ProcessTable::Acquire(long pid) {
+  std::uint32_t slot;
+  if (!this->free_slots.empty()) {
+    slot = this->free_slots.back();
+    this->free_slots.pop_back();
+  } else {
+    slot = static_cast<std::uint32_t>(this->pids.size());
+    this->pids.push_back(0);
+    this->generations.push_back(0);
+    this->seen.push_back(0);
+    this->fresh.push_back(0);
+    this->start_times.push_back(0);
+    this->utimes.push_back(0);
+    this->stimes.push_back(0);
+    this->last_ticks.push_back(0);
+    this->rss.push_back(0);
+    this->read_bytes.push_back(0);
+    this->write_bytes.push_back(0);
+    this->run_times.push_back(0);
+    this->wait_times.push_back(0);
+    this->last_run_times.push_back(0);
+    this->last_wait_times.push_back(0);
+    this->scheduled.push_back(0);
+    this->pss.push_back(0);
+    this->uss.push_back(0);
+    this->swap.push_back(0);
+    this->pss_anon.push_back(0);
+    this->pss_file.push_back(0);
+    this->memory_times.emplace_back();
+    this->cpu.push_back(0);
+    this->run_delays.push_back(0);
+    this->wait_ratios.push_back(0);
+    this->comm_hashes.push_back(0);
+    this->commands.push_back(StringPool::kEmpty);
+    this->users.push_back(StringPool::kEmpty);
+  }
+
+  this->pids[slot] = static_cast<std::int32_t>(pid);
+  this->Reset(slot);
+  this->slots.emplace(pid, slot);
+  return slot;
+}
+
+/**
+ * @brief Clear the history of a slot, for a process seen for the first time
+ *
+ * @param slot
+ */
+void ProcessTable::Reset(std::uint32_t slot) {
+  ++this->generations[slot];
+  this->fresh[slot] = 1;
+  this->utimes[slot] = 0;
+  this->stimes[slot] = 0;
+  this->last_ticks[slot] = 0;
+  this->run_times[slot] = 0;
+  this->wait_times[slot] = 0;
+  this->scheduled[slot] = 0;
+  this->memory_times[slot] = {};
+  this->pss[slot] = 0;
+  this->uss[slot] = 0;
+  this->swap[slot] = 0;
+  this->pss_anon[slot] = 0;
+  this->pss_file[slot] = 0;
+}
+
+/**
+ * @brief Return a slot to the free list and invalidate its handles
+ *
+ * @param slot
+ */
+void ProcessTable::Release(std::uint32_t slot) {
+  this->slots.erase(this->pids[slot]);
+  ++this->generations[slot];
+  this->pids[slot] = 0;
+  this->seen[slot] = 0;
+  this->strings.Release(this->commands[slot]);
+  this->commands[slot] = StringPool::kEmpty;
+  this->free_slots.push_back(slot);
+}
+
+/**
+ * @brief Read the raw counters of the process in a slot
+ *
+ * A process that exited between listing /proc and reading its files is left
+ * unmarked and released at the end of the tick.
+ *
+ * @param slot
+ * @param content buffer for the file contents
+ */
+void ProcessTable::Sample(std::uint32_t slot, std::pmr::string& content) {
+  using namespace LinuxParser::StatFields;
+  LinuxParser::ProcessStat stat;
+  if (!LinuxParser::Stat<Utime, Stime, Starttime, Rss>(this->pids[slot], stat,
+                                                       content)) {
+    return;
+  }
+  LinuxParser::ProcessIo io;
+  bool has_io = LinuxParser::Io(this->pids[slot], io, content);
+  LinuxParser::ProcessSchedstat schedstat;
+  bool has_schedstat =
+      LinuxParser::Schedstat(this->pids[slot], schedstat, content);
+  this->Store(slot, stat, has_io ? &io : nullptr,
+              has_schedstat ? &schedstat : nullptr, content);
+}
+
+/**
+ * @brief Read the files of the pending slots with io_uring, then sample them
+ *
+ * If the ring fails, the batch (and the next ones) are read synchronously.
+ *
+ * @param content buffer for the files read synchronously
+ */
+void ProcessTable::SampleBatch(std::pmr::string& content) {
+  using namespace LinuxParser::StatFields;
+  std::size_t count = this->pending.size();
+  for (std::size_t i = 0; i < count; ++i) {
+    long pid = this->pids[this->pending[i]];
+    for (std::size_t file = 0; file < kFiles; ++file) {
+      static std::string const* const names[kFiles]{
+          &LinuxParser::kStatFilename, &LinuxParser::kIoFilename,
+          &LinuxParser::kSchedstatFilename};
+      auto& path = this->paths[kFiles * i + file];
+      auto const& name = *names[file];
+      char* end = std::copy(LinuxParser::kProcDirectory.begin(),
+                            LinuxParser::kProcDirectory.end(), path.data());
+      end = std::to_chars(end, path.data() + path.size(), pid).ptr;
+      *std::copy(name.begin(), name.end(), end) = '\0';
+    }
+  }
+  this->uring->Read(this->requests.data(), kFiles * count);
+
+  if (!this->uring->Available()) {
+    for (auto slot : this->pending) {
+      this->Sample(slot, content);
+    }
+    this->uring.reset();
+    this->pending.clear();
+    return;
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    auto const& stat_file = this->requests[kFiles * i];
+    auto const& io_file = this->requests[kFiles * i + 1];
+    auto const& schedstat_file = this->requests[kFiles * i + 2];
+    LinuxParser::ProcessStat stat;
+    if (stat_file.result <= 0 ||
+        !LinuxParser::ParseStat<Utime, Stime, Starttime, Rss>(
+            std::string_view(stat_file.buffer, stat_file.result), stat)) {
+      continue;
+    }
+    LinuxParser::ProcessIo io;
+    if (io_file.result > 0) {
+      io = LinuxParser::ParseIo(
+          std::string_view(io_file.buffer, io_file.result));
+    }
+    LinuxParser::ProcessSchedstat schedstat;
+    if (schedstat_file.result > 0) {
+      schedstat = LinuxParser::ParseSchedstat(
+          std::string_view(schedstat_file.buffer, schedstat_file.result));
+    }
+    this->Store(this->pending[i], stat, io_file.result > 0 ? &io : nullptr,
+                schedstat_file.result > 0 ? &schedstat : nullptr, content);
+  }
+  this->pending.clear();
+}
+
+/**
+ * @brief Store the counters read for the process in a slot
+ *
+ * The counters of a file that could not be read keep their previous values.
+ *
+ * @param slot
+ * @param stat parsed /proc/<pid>/stat
+ * @param io parsed /proc/<pid>/io, nullptr if it could not be read
+ * @param schedstat parsed /proc/<pid>/schedstat, nullptr if it could not be
+ * read
+ * @param content buffer for the files read to identify a new process
+ */
+void ProcessTable::Store(std::uint32_t slot,
+                         LinuxParser::ProcessStat const& stat,
+                         LinuxParser::ProcessIo const* io,
+                         LinuxParser::ProcessSchedstat const* schedstat,
+                         std::pmr::string& content) {
+  // a recycled pid belongs to a new process: start its history over
+  if (!this->fresh[slot] && this->start_times[slot] != stat.starttime) {
+    this->Reset(slot);
+  }
+  // a new comm means the process called exec: its command line changed too
+  std::uint32_t comm = CommHash(stat.comm);
+  if (this->fresh[slot] || this->comm_hashes[slot] != comm) {
+    this->Identify(slot, content);
+    this->comm_hashes[slot] = comm;
+  }
+
+  this->seen[slot] = this->tick;
+  this->start_times[slot] = stat.starttime;
+  this->utimes[slot] = stat.utime;
+  this->stimes[slot] = stat.stime;
+  this->rss[slot] = stat.rss;
+  if (io != nullptr) {
+    this->read_bytes[slot] = io->read_bytes;
+    this->write_bytes[slot] = io->write_bytes;
+  }
+  if (schedstat != nullptr) {
+    this->run_times[slot] = schedstat->run_time;
+    this->wait_times[slot] = schedstat->wait_time;
+    // without a reading on the previous tick there is no interval to measure
+    if (this->scheduled[slot] != this->tick - 1) {
+      this->last_run_times[slot] = this->run_times[slot];
+      this->last_wait_times[slot] = this->wait_times[slot];
+    }
+    this->scheduled[slot] = this->tick;
+  }
+}
+
+/**
+ * @brief Intern the command line and the user of a new process
+ *
+ * Only the program (the first argument) of the command line is kept, so
+ * workers forked from one program share their string.
+ *
+ * @param slot
+ * @param content buffer for the file content
+ */
+void ProcessTable::Identify(std::uint32_t slot, std::pmr::string& content) {
+  long pid = this->pids[slot];
+  std::string_view command;
+  if (LinuxParser::ReadFile(
+          LinuxParser::Path(pid, LinuxParser::kCmdlineFilename), content)) {
+    command = std::string_view(content);
+    command = command.substr(0, command.find('\0'));
+  }
+  this->strings.Release(this->commands[slot]);
+  this->commands[slot] = this->strings.Intern(command);
+  this->users[slot] = this->UserName(LinuxParser::Uid(pid));
+}
+
+/**
+ * @brief Return the interned name of a user
+ *
+ * /etc/passwd is read again only when an unknown user shows up; users
+ * missing from it are named after their ID.
+ *
+ * @param uid user ID
+ * @return StringPool::Id
+ */
+StringPool::Id ProcessTable::UserName(long uid) {
+  if (uid < 0) {
+    return StringPool::kEmpty;
+  }
+
+  auto it = this->user_names.find(uid);
+  if (it != this->user_names.end()) {
+    return it->second;
+  }
+
+  for (auto const& user : LinuxParser::Users()) {
+    if (this->user_names.count(user.first) == 0) {
+      this->user_names.emplace(user.first, this->strings.Intern(user.second));
+    }
+  }
+  it = this->user_names.find(uid);
+  if (it != this->user_names.end()) {
+    return it->second;
+  }
+  auto id = this->strings.Intern(std::to_string(uid));
+  return this->user_names.emplace(uid, id).first->second;
+}
+
+/**
+ * @brief Compute the CPU utilization and run queue columns from the sampled
+ * counters
+ *
+ * Processes with a previous sample get their utilization over the last
+ * interval; new ones get their average over their whole lifetime.
+ * The run delay is the time spent waiting on a run queue during the last
+ * interval, and the wait ratio its share of the time spent runnable; both
+ * stay 0 until a process has a previous sample, and on the ticks its
+ * schedstat could not be read.
+ *
+ * @param seconds wall time elapsed since the previous sample
+ */
+void ProcessTable::Rates(double seconds) {
+  static const double hz = static_cast<double>(sysconf(_SC_CLK_TCK));
+  double interval = seconds * hz;
+  double uptime = this->uptime * hz;
+
+  // counters are subtracted as integers: a float cannot tell consecutive
+  // ticks apart beyond 2^24 of them
+  for (std::size_t i = 0; i < this->pids.size(); ++i) {
+    std::uint64_t ticks = this->utimes[i] + this->stimes[i];
+    if (this->fresh[i]) {
+      double age = uptime - static_cast<double>(this->start_times[i]);
+      this->cpu[i] =
+          age > 0 ? static_cast<float>(static_cast<double>(ticks) / age) : 0;
+    } else {
+      std::uint64_t delta =
+          ticks > this->last_ticks[i] ? ticks - this->last_ticks[i] : 0;
+      this->cpu[i] =
+          interval > 0
+              ? static_cast<float>(static_cast<double>(delta) / interval)
+              : 0;
+    }
+  }
+
+  std::uint64_t total_run{0};
+  std::uint64_t total_wait{0};
+  for (std::size_t i = 0; i < this->pids.size(); ++i) {
+    // a slot without a schedstat reading this tick stays out of the totals
+    if (this->fresh[i] || this->scheduled[i] != this->tick) {
+      this->run_delays[i] = 0;
+      this->wait_ratios[i] = 0;
+      continue;
+    }
+    std::uint64_t run = this->run_times[i] > this->last_run_times[i]
+                            ? this->run_times[i] - this->last_run_times[i]
+                            : 0;
+    std::uint64_t wait = this->wait_times[i] > this->last_wait_times[i]
+                             ? this->wait_times[i] - this->last_wait_times[i]
+                             : 0;
+    this->run_delays[i] = static_cast<float>(wait) / 1e6f;
+    this->wait_ratios[i] = run + wait > 0 ? static_cast<float>(wait) /
+                                                static_cast<float>(run + wait)
+                                          : 0;
+    total_run += run;
+    total_wait += wait;
+  }
+  this->total_run_delay = static_cast<float>(total_wait) / 1e6f;
+  this->total_wait_ratio =
+      total_run + total_wait > 0
+          ? static_cast<float>(total_wait) /
+                static_cast<float>(total_run + total_wait)
+          : 0;
+
+  for (std::size_t i = 0; i < this->pids.size(); ++i) {
+    this->fresh[i] = this->fresh[i] && this->seen[i] != this->tick;
+  }
+}
+
+/**
+ * @brief Read the memory breakdown of as many processes as the budget allows
+ *
+ * The first rows of the order, which are the ones displayed and exported,
+ * are read every tick. The others are read round-robin, resuming where the
+ * previous tick stopped, until the budget is spent; their values age in the
+ * meantime.
+ *
+ * @param content buffer for the file contents
+ */
+void ProcessTable::SampleMemory(std::pmr::string& content) {
+  auto deadline = std::chrono::steady_clock::now() + this->memory_budget;
+  std::size_t priority = std::min(this->memory_priority, this->order.size());
+  for (std::size_t i = 0; i < priority; ++i) {
+    this->ReadMemory(this->order[i], content);
+  }
+
+  for (std::size_t visited = 0; visited < this->pids.size(); ++visited) {
+    if (this->memory_cursor >= this->pids.size()) {
+      this->memory_cursor = 0;
+    }
+    std::uint32_t slot = this->memory_cursor;
+    if (this->seen[slot] != this->tick ||
+        this->memory_times[slot] == this->sampled) {
+      ++this->memory_cursor;
+      continue;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    this->ReadMemory(slot, content);
+    ++this->memory_cursor;
+  }
+
+  this->total_pss = 0;
+  this->memory_covered = 0;
+  this->oldest_memory_age = 0;
+  for (auto slot : this->order) {
+    double age = this->MemoryAge(slot);
+    if (age >= 0) {
+      this->total_pss += this->pss[slot];
+      ++this->memory_covered;
+      this->oldest_memory_age = std::max(this->oldest_memory_age, age);
+    }
+  }
+}
+
+/**
+ * @brief Read the memory breakdown of the process in a slot
+ *
+ * Processes whose smaps_rollup cannot be read keep their previous values,
+ * and their age.
+ *
+ * @param slot
+ * @param content buffer for the file content
+ */
+void ProcessTable::ReadMemory(std::uint32_t slot, std::pmr::string& content) {
+  LinuxParser::ProcessMemory memory;
+  if (!LinuxParser::Memory(this->pids[slot], memory, content)) {
+    return;
+  }
+  this->pss[slot] = memory.pss;
+  this->uss[slot] = memory.private_clean + memory.private_dirty;
+  this->swap[slot] = memory.swap;
+  this->pss_anon[slot] = memory.pss_anon;
+  this->pss_file[slot] = memory.pss_file;
+  this->memory_times[slot] = this->sampled;
+}
+
+/**
+ * @brief Rebuild the order of the live slots, descending by the sort key
+ */
+void ProcessTable::Sort() {
+  this->order.clear();
+  for (std::uint32_t i = 0; i < this->pids.size(); ++i) {
+    if (this->seen[i] == this->tick) {
+      this->order.push_back(i);
+    }
+  }
+
+  auto const& column =
+      this->sort_key == SortKey::kRunDelay ? this->run_delays : this->cpu;
+  std::sort(this->order.begin(), this->order.end(),
+            [&column](std::uint32_t a, std::uint32_t b) {
+              return column[a] > column[b];
+            });
+}
@@ -0,0 +1,59 @@
+#include "string_pool.h"
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Construct a new String Pool:: String Pool object, holding the empty
+ * string
+ *
+ */
+StringPool::StringPool() {
+  this->strings.emplace_back();
+  this->references.push_back(1);
+}
+
+/**
+ * @brief Take a reference to a string, adding it to the pool if needed
+ *
+ * @param value
+ * @return Id of the string
+ */
+StringPool::Id StringPool::Intern(std::string_view value) {
+  if (value.empty()) {
+    return kEmpty;
+  }
+
+  auto it = this->index.find(value);
+  if (it != this->index.end()) {
+    ++this->references[it->second];
+    return it->second;
+  }
+
+  Id id;
+  if (!this->free_ids.empty()) {
+    id = this->free_ids.back();
+    this->free_ids.pop_back();
+    this->strings[id].assign(value);
+  } else {
+    id = static_cast<Id>(this->strings.size());
+    this->strings.emplace_back(value);
+    this->references.push_back(0);
+  }
+  this->references[id] = 1;
+  this->index.emplace(this->strings[id], id);
+  return id;
+}
+
+/**
+ * @brief Drop a reference to a string, recycling its id after the last one
+ *
+ * @param id
+ */
+void StringPool::Release(Id id) {
+  if (id == kEmpty || --this->references[id] > 0) {
+    return;
+  }
+  this->index.erase(this->strings[id]);
+  this->free_ids.push_back(id);
+}
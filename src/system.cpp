@@ -3,14 +3,22 @@
 #include <unistd.h>
 
 #include <cstddef>
-#include <set>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
 #include "linux_parser.h"
 #include "process.h"
+#include "process_table.h"
 #include "processor.h"
 
+/**
+ * @brief Destroy the System:: System object, detaching its scratch memory
+ * from the parser
+ *
+ */
+System::~System() { LinuxParser::ScratchResource(nullptr); }
+
 /**
  * @brief
  *
@@ -19,37 +27,106 @@
 Processor& System::Cpu() { return this->cpu; }
 
 /**
- * @brief
+ * @brief Return the aggregate CPU utilization sampled by the last update
  *
- * @return std::set<Process>&
+ * @return float
  */
-std::set<Process>& System::Processes() { return this->proc; }
+float System::CpuUtilization() { return this->cpu_utilization; }
 
 /**
- * @brief
+ * @brief Return the processes, sorted by descending CPU utilization
+ *
+ * @return std::vector<Process>&
+ */
+std::vector<Process>& System::Processes() { return this->proc; }
+
+/**
+ * @brief Return the scratch memory of the current tick
+ *
+ * @return std::pmr::memory_resource*
+ */
+std::pmr::memory_resource* System::Arena() { return &this->arena; }
+
+/**
+ * @brief Return the table holding the sampled process data
+ *
+ * @return ProcessTable&
+ */
+ProcessTable& System::Table() { return this->table; }
+
+/**
+ * @brief Take a new snapshot of the system and of its processes
+ *
+ * The accessors below return the values of the last snapshot, so rendering
+ * it any number of times does not read /proc again. The scratch memory of
+ * the previous tick is released first; the parser and the display allocate
+ * their temporaries from it until the next update.
+ */
+void System::update() {
+  this->arena.release();
+  LinuxParser::ScratchResource(&this->arena);
+  if (this->kernel.empty()) {
+    this->kernel = LinuxParser::Kernel();
+    this->os = LinuxParser::OperatingSystem();
+  }
+  this->cpu_utilization = this->cpu.Utilization();
+  this->memory_utilization = LinuxParser::MemoryUtilization();
+  this->uptime = LinuxParser::UpTime();
+  this->total_processes = LinuxParser::TotalProcesses();
+  this->running_processes = LinuxParser::RunningProcesses();
+  this->updateProcesses();
+}
+
+/**
+ * @brief Sample the processes and rebuild their sorted views
  *
  */
 void System::updateProcesses() {
+  this->table.Update();
   this->proc.clear();
-  for (auto pid : LinuxParser::Pids()) {
-    this->proc.emplace(pid);
+  for (auto slot : this->table.Order()) {
+    this->proc.emplace_back(this->table, this->table.HandleOf(slot));
   }
 }
 
+/**
+ * @brief Sort the processes of the snapshot by another column
+ *
+ * @param key
+ */
+void System::SortBy(ProcessTable::SortKey key) {
+  this->table.SortBy(key);
+  this->proc.clear();
+  for (auto slot : this->table.Order()) {
+    this->proc.emplace_back(this->table, this->table.HandleOf(slot));
+  }
+}
+
+// Return the proportional memory of the processes read so far (megabytes)
+double System::ProportionalMemory() {
+  return static_cast<double>(this->table.TotalPss()) / 1024.0;
+}
+
+// Return the time the processes waited on run queues in the last interval (ms)
+float System::RunDelay() { return this->table.TotalRunDelay(); }
+
+// Return the share of the runnable time the processes spent waiting
+float System::WaitRatio() { return this->table.TotalWaitRatio(); }
+
 // Return the system's kernel identifier (string)
-std::string System::Kernel() { return LinuxParser::Kernel(); }
+std::string const& System::Kernel() { return this->kernel; }
 
 // Return the system's memory utilization
-float System::MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
+float System::MemoryUtilization() { return this->memory_utilization; }
 
 // Return the operating system name
-std::string System::OperatingSystem() { return LinuxParser::OperatingSystem(); }
+std::string const& System::OperatingSystem() { return this->os; }
 
 // Return the number of processes actively running on the system
-long System::RunningProcesses() { return LinuxParser::RunningProcesses(); }
+long System::RunningProcesses() { return this->running_processes; }
 
 // Return the total number of processes on the system
-long System::TotalProcesses() { return LinuxParser::TotalProcesses(); }
+long System::TotalProcesses() { return this->total_processes; }
 
 // Return the number of seconds since the system started running
-long System::UpTime() { return LinuxParser::UpTime(); }
\ No newline at end of file
+long System::UpTime() { return this->uptime; }
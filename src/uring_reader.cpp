@@ -0,0 +1,311 @@
+#include "uring_reader.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// flag of the user_data of the close operations, next to the request index
+const std::uint64_t kCloseTag{std::uint64_t{1} << 63};
+
+/**
+ * @brief Construct a new Uring Reader:: Uring Reader object
+ *
+ * Sets up the ring, maps its queues and checks that the kernel supports the
+ * operations used. On failure the reader is left unavailable.
+ *
+ * @param entries submission queue size, the largest batch is half of it
+ */
+UringReader::UringReader(unsigned entries) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd < 0) {
+    return;
+  }
+
+  this->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  this->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single) {
+    this->sq_ring_size = this->cq_ring_size =
+        std::max(this->sq_ring_size, this->cq_ring_size);
+  }
+
+  this->sq_ring = mmap(nullptr, this->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  this->cq_ring = single ? this->sq_ring
+                         : mmap(nullptr, this->cq_ring_size,
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, fd,
+                                IORING_OFF_CQ_RING);
+  this->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (this->sq_ring == MAP_FAILED || this->cq_ring == MAP_FAILED ||
+      sqes == MAP_FAILED) {
+    if (this->sq_ring != MAP_FAILED) munmap(this->sq_ring, this->sq_ring_size);
+    if (!single && this->cq_ring != MAP_FAILED)
+      munmap(this->cq_ring, this->cq_ring_size);
+    if (sqes != MAP_FAILED) munmap(sqes, this->sqes_size);
+    this->sq_ring = this->cq_ring = nullptr;
+    close(fd);
+    return;
+  }
+
+  auto* sq = static_cast<char*>(this->sq_ring);
+  auto* cq = static_cast<char*>(this->cq_ring);
+  this->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  this->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  this->sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  this->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  this->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  this->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  this->cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  this->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  this->sqes = static_cast<io_uring_sqe*>(sqes);
+  this->entries = params.sq_entries;
+  this->ring_fd = fd;
+  if (!this->Probe()) {
+    this->Teardown();
+  }
+}
+
+/**
+ * @brief Check that the kernel supports the open, read and close operations
+ *
+ * Before Linux 5.6 the ring can be set up but every open completes with
+ * -EINVAL; those kernels do not support probing either.
+ *
+ * @return true if the batches can be read through the ring
+ */
+bool UringReader::Probe() {
+  const unsigned count{256};
+  std::vector<std::uint64_t> buffer(
+      (sizeof(io_uring_probe) + count * sizeof(io_uring_probe_op)) /
+          sizeof(std::uint64_t) +
+      1);
+  auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+  if (syscall(__NR_io_uring_register, this->ring_fd, IORING_REGISTER_PROBE,
+              probe, count) < 0) {
+    return false;
+  }
+  for (unsigned op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+    if (op > probe->last_op ||
+        !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Destroy the Uring Reader:: Uring Reader object, unmapping its
+ * queues
+ *
+ */
+UringReader::~UringReader() { this->Teardown(); }
+
+/**
+ * @brief Unmap the queues and close the ring, leaving the reader unavailable
+ *
+ */
+void UringReader::Teardown() {
+  if (this->ring_fd < 0) {
+    return;
+  }
+  munmap(this->sqes, this->sqes_size);
+  if (this->cq_ring != this->sq_ring) {
+    munmap(this->cq_ring, this->cq_ring_size);
+  }
+  munmap(this->sq_ring, this->sq_ring_size);
+  close(this->ring_fd);
+  this->ring_fd = -1;
+}
+
+/**
+ * @brief Read files from their start, in batches
+ *
+ * Each request gets the number of bytes read into its buffer, or -errno if
+ * the file could not be opened or read. If the ring itself fails, the
+ * reader becomes unavailable and the remaining requests get -EIO.
+ *
+ * @param requests
+ * @param count number of requests
+ */
+void UringReader::Read(Request* requests, std::size_t count) {
+  // every file takes a read and a close in the second submission
+  std::size_t batch = this->entries / 2;
+  for (std::size_t i = 0; i < count; ++i) {
+    requests[i].result = -EIO;
+  }
+  for (std::size_t i = 0; i < count && this->Available(); i += batch) {
+    if (!this->ReadChunk(requests + i, std::min(batch, count - i))) {
+      this->Teardown();
+    }
+  }
+}
+
+/**
+ * @brief Open, read and close a batch of files in two submissions
+ *
+ * @param requests
+ * @param count number of requests, at most half the queue size
+ * @return false if the ring failed
+ */
+bool UringReader::ReadChunk(Request* requests, std::size_t count) {
+  this->fds.assign(count, -1);
+  // the ring failed: wait for what the kernel took, which may still open or
+  // close files, then close the files left open
+  unsigned reaped{0};
+  unsigned head = __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE);
+  auto fail = [&](auto complete) {
+    unsigned taken = __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE) - head;
+    this->Reap(taken - reaped, complete);
+    for (int fd : this->fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    return false;
+  };
+
+  for (std::size_t i = 0; i < count; ++i) {
+    io_uring_sqe* sqe = this->NextSqe();
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<std::uint64_t>(requests[i].path);
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    sqe->user_data = i;
+  }
+  auto opens = static_cast<unsigned>(count);
+  auto open = [&](std::uint64_t i, int result) {
+    ++reaped;
+    if (result >= 0) {
+      this->fds[i] = result;
+    } else {
+      requests[i].result = result;
+    }
+  };
+  if (!this->Submit(opens, opens) || !this->Reap(opens, open)) {
+    return fail(open);
+  }
+
+  // the close is hard linked to the read, so it runs even if the read fails
+  reaped = 0;
+  head = __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE);
+  unsigned submitted{0};
+  for (std::size_t i = 0; i < count; ++i) {
+    if (this->fds[i] < 0) {
+      continue;
+    }
+    io_uring_sqe* read = this->NextSqe();
+    read->opcode = IORING_OP_READ;
+    read->flags = IOSQE_IO_HARDLINK;
+    read->fd = this->fds[i];
+    read->addr = reinterpret_cast<std::uint64_t>(requests[i].buffer);
+    read->len = static_cast<std::uint32_t>(requests[i].capacity);
+    read->off = 0;
+    read->user_data = i;
+    io_uring_sqe* close = this->NextSqe();
+    close->opcode = IORING_OP_CLOSE;
+    close->fd = this->fds[i];
+    close->user_data = kCloseTag | i;
+    submitted += 2;
+  }
+  auto read = [&](std::uint64_t i, int result) {
+    ++reaped;
+    if (i & kCloseTag) {
+      this->fds[i & ~kCloseTag] = -1;
+    } else {
+      requests[i].result = result;
+    }
+  };
+  if (submitted > 0 && (!this->Submit(submitted, submitted) ||
+                        !this->Reap(submitted, read))) {
+    return fail(read);
+  }
+  return true;
+}
+
+/**
+ * @brief Return a cleared submission queue entry, queued at the tail
+ *
+ * @return io_uring_sqe*
+ */
+io_uring_sqe* UringReader::NextSqe() {
+  unsigned tail = *this->sq_tail;
+  unsigned index = tail & *this->sq_mask;
+  io_uring_sqe* sqe = &this->sqes[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  this->sq_array[index] = index;
+  __atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  return sqe;
+}
+
+/**
+ * @brief Submit the queued entries and wait for their completions
+ *
+ * @param count entries to submit
+ * @param wait completions to wait for
+ * @return false if the kernel refused the submission
+ */
+bool UringReader::Submit(unsigned count, unsigned wait) {
+  while (count > 0 || wait > 0) {
+    long result = syscall(__NR_io_uring_enter, this->ring_fd, count, wait,
+                          IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    count -= static_cast<unsigned>(result);
+    unsigned ready = __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE) -
+                     *this->cq_head;
+    wait = ready >= wait ? 0 : wait;
+  }
+  return true;
+}
+
+/**
+ * @brief Consume completions
+ *
+ * @param count completions to consume
+ * @param complete called with the user_data and the result of each one
+ * @return false if waiting for a completion failed; the completions
+ * consumed until then are not delivered again
+ */
+template <typename Complete>
+bool UringReader::Reap(unsigned count, Complete complete) {
+  unsigned head = *this->cq_head;
+  while (count > 0) {
+    unsigned tail = __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      // completions still in flight
+      long result = syscall(__NR_io_uring_enter, this->ring_fd, 0, 1,
+                            IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (result < 0 && errno != EINTR) {
+        __atomic_store_n(this->cq_head, head, __ATOMIC_RELEASE);
+        return false;
+      }
+      continue;
+    }
+    io_uring_cqe const& cqe = this->cqes[head & *this->cq_mask];
+    complete(cqe.user_data, cqe.res);
+    ++head;
+    --count;
+  }
+  __atomic_store_n(this->cq_head, head, __ATOMIC_RELEASE);
+  return true;
+}
@@ -0,0 +1,313 @@
+#include "watcher.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_stat.h"
+
+/**
+ * @brief Return the value at a percentile of a set of values
+ *
+ * @param values values, reordered in place
+ * @param percentile in [0, 1]
+ * @return float
+ */
+static float Percentile(std::vector<float>& values, float percentile) {
+  auto nth = values.begin() + static_cast<long>(percentile *
+                                                (values.size() - 1));
+  std::nth_element(values.begin(), nth, values.end());
+  return *nth;
+}
+
+/**
+ * @brief Read a /proc file from the start through an open descriptor
+ *
+ * @param fd file descriptor
+ * @param buffer destination buffer
+ * @return number of bytes read, 0 on failure
+ */
+template <std::size_t N>
+static std::size_t Reread(int fd, std::array<char, N>& buffer) {
+  auto count = pread(fd, buffer.data(), buffer.size() - 1, 0);
+  return count > 0 ? static_cast<std::size_t>(count) : 0;
+}
+
+/**
+ * @brief Construct a new Watcher:: Watcher object
+ *
+ * @param options targets and sampling parameters
+ */
+Watcher::Watcher(WatchOptions const& options)
+    : options(options), system(options.capacity) {
+  this->stat_fd = open((LinuxParser::kProcDirectory + "stat").c_str(),
+                       O_RDONLY | O_CLOEXEC);
+  this->Resolve();
+}
+
+/**
+ * @brief Destroy the Watcher:: Watcher object, closing its descriptors
+ *
+ */
+Watcher::~Watcher() {
+  for (auto& target : this->targets) {
+    if (target.fd >= 0) {
+      close(target.fd);
+    }
+  }
+  if (this->stat_fd >= 0) {
+    close(this->stat_fd);
+  }
+}
+
+/**
+ * @brief Open the files of the requested pids and of the processes whose
+ * command name matches the pattern
+ *
+ * The pattern is matched against argv[0] and comm, not the arguments, so
+ * a shell or a monitor mentioning the name on their command line do not
+ * match. Matching a pattern is the only time /proc is scanned.
+ */
+void Watcher::Resolve() {
+  std::vector<long> pids = this->options.pids;
+  if (!this->options.pattern.empty()) {
+    std::regex pattern(this->options.pattern);
+    for (auto pid : LinuxParser::Pids()) {
+      std::string command = LinuxParser::Command(pid);
+      command = command.substr(0, command.find('\0'));
+      if (pid != getpid() &&
+          (std::regex_search(command, pattern) ||
+           std::regex_search(LinuxParser::Comm(pid), pattern))) {
+        pids.push_back(pid);
+      }
+    }
+  }
+
+  for (auto pid : pids) {
+    int fd = open((LinuxParser::kProcDirectory + std::to_string(pid) +
+                   LinuxParser::kStatFilename)
+                      .c_str(),
+                  O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      std::cerr << "watch: cannot open process " << pid << ": "
+                << std::strerror(errno) << "\n";
+      continue;
+    }
+    std::string command = LinuxParser::Command(pid);
+    command = command.substr(0, command.find('\0'));
+    clockid_t clock;
+    bool has_clock = clock_getcpuclockid(static_cast<pid_t>(pid), &clock) == 0;
+    this->targets.push_back(Target{pid, command, fd, has_clock, clock, 0,
+                                   Clock::time_point{},
+                                   RingBuffer<Sample>(this->options.capacity)});
+  }
+}
+
+/**
+ * @brief Sample the aggregate CPU utilization from the first line of
+ * /proc/stat
+ *
+ * /proc/stat only counts clock ticks, so samples span at least 10 ticks
+ * (100 ms at 100 Hz) whatever the interval: over a single tick, each sample
+ * would be either 0 or 100%.
+ *
+ * @param now sampling time
+ * @return true if a sample was recorded
+ */
+bool Watcher::SampleSystem(Clock::time_point now) {
+  static const auto span = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(10.0 / sysconf(_SC_CLK_TCK)));
+  if (now - this->system_sampled < span) {
+    return false;
+  }
+  this->system_sampled = now;
+
+  auto count = Reread(this->stat_fd, this->buffer);
+  if (count == 0) {
+    return false;
+  }
+  this->buffer[count] = '\0';
+
+  std::istringstream lstream(this->buffer.data());
+  std::string cpu;
+  unsigned long value;
+  unsigned long total{0};
+  unsigned long idle{0};
+  lstream >> cpu;
+  for (int state = 0; state <= LinuxParser::kSteal_ && lstream >> value;
+       ++state) {
+    total += value;
+    if (state == LinuxParser::kIdle_ || state == LinuxParser::kIOwait_) {
+      idle += value;
+    }
+  }
+
+  bool first = this->total == 0;
+  float delta = static_cast<float>(total - this->total);
+  float busy = delta - static_cast<float>(idle - this->idle);
+  this->total = total;
+  this->idle = idle;
+  if (first) {
+    return false;
+  }
+  this->system.Push(Sample{now, delta > 0 ? busy / delta : 0, 0});
+  return true;
+}
+
+/**
+ * @brief Sample the CPU utilization and resident memory of a target
+ *
+ * The CPU time comes from the CPU-time clock of the process. Where it cannot
+ * be read, it comes from /proc/<pid>/stat, whose clock ticks make single
+ * samples coarse at high rates.
+ *
+ * @param target process to sample
+ * @param now sampling time
+ * @return false if the process exited
+ */
+bool Watcher::SampleTarget(Target& target, Clock::time_point now) {
+  using namespace LinuxParser::StatFields;
+  static const double hz = static_cast<double>(sysconf(_SC_CLK_TCK));
+
+  auto count = Reread(target.fd, this->buffer);
+  LinuxParser::ProcessStat stat;
+  if (count == 0 ||
+      !LinuxParser::ParseStat<Utime, Stime, Rss>(
+          std::string_view(this->buffer.data(), count), stat)) {
+    return false;
+  }
+
+  double cpu_time = static_cast<double>(stat.utime + stat.stime) / hz;
+  timespec clock_time;
+  if (target.has_clock && clock_gettime(target.clock, &clock_time) == 0) {
+    cpu_time = static_cast<double>(clock_time.tv_sec) +
+               static_cast<double>(clock_time.tv_nsec) / 1e9;
+  } else {
+    target.has_clock = false;
+  }
+
+  if (target.sampled != Clock::time_point{}) {
+    double seconds =
+        std::chrono::duration<double>(now - target.sampled).count();
+    double busy = std::max(cpu_time - target.cpu_time, 0.0);
+    target.samples.Push(
+        Sample{now, static_cast<float>(busy / seconds), stat.rss});
+  }
+  target.cpu_time = cpu_time;
+  target.sampled = now;
+  return true;
+}
+
+/**
+ * @brief Write the percentiles of the samples taken during the last window
+ *
+ * @param samples samples of one process (or of the system)
+ * @param now end of the window
+ */
+void Watcher::ReportLine(RingBuffer<Sample> const& samples,
+                         Clock::time_point now) {
+  static const float page = static_cast<float>(sysconf(_SC_PAGESIZE));
+
+  this->scratch.clear();
+  long rss{0};
+  for (std::size_t i = samples.Size(); i > 0; --i) {
+    auto const& sample = samples[i - 1];
+    if (now - sample.time > this->options.window) {
+      break;
+    }
+    this->scratch.push_back(sample.cpu * 100);
+    rss = std::max(rss, sample.rss);
+  }
+
+  std::cout << std::fixed << std::setprecision(1);
+  if (this->scratch.empty()) {
+    std::cout << " no samples\n";
+    return;
+  }
+  std::cout << " n " << std::setw(5) << this->scratch.size() << "  cpu%"
+            << " p50 " << std::setw(5) << Percentile(this->scratch, 0.50)
+            << " p90 " << std::setw(5) << Percentile(this->scratch, 0.90)
+            << " p99 " << std::setw(5) << Percentile(this->scratch, 0.99)
+            << " max " << std::setw(5) << Percentile(this->scratch, 1.0);
+  if (rss > 0) {
+    std::cout << "  rss[MB] " << rss * page / (1024 * 1024);
+  }
+  std::cout << "\n";
+}
+
+/**
+ * @brief Write the window report of the system and of every target
+ *
+ * @param now end of the window
+ */
+void Watcher::Report(Clock::time_point now) {
+  std::cout << std::left << std::setw(24) << "system" << std::right;
+  this->ReportLine(this->system, now);
+  for (auto const& target : this->targets) {
+    std::ostringstream name;
+    name << target.pid << " " << target.command.substr(0, 16);
+    std::cout << std::left << std::setw(24) << name.str() << std::right;
+    if (target.fd < 0) {
+      std::cout << " exited\n";
+    } else {
+      this->ReportLine(target.samples, now);
+    }
+  }
+  std::cout << std::endl;
+}
+
+/**
+ * @brief Sample the targets at the configured interval until they all exit
+ *
+ * @return exit status
+ */
+int Watcher::Run() {
+  if (this->targets.empty()) {
+    std::cerr << "watch: no process to watch\n";
+    return 1;
+  }
+
+  auto next = Clock::now();
+  auto window_end = next + this->options.window;
+  std::size_t alive = this->targets.size();
+  while (alive > 0) {
+    auto now = Clock::now();
+    this->SampleSystem(now);
+    for (auto& target : this->targets) {
+      if (target.fd >= 0 && !this->SampleTarget(target, now)) {
+        close(target.fd);
+        target.fd = -1;
+        --alive;
+      }
+    }
+
+    if (now >= window_end) {
+      this->Report(now);
+      window_end += this->options.window;
+    }
+
+    // sleep until the next deadline, skipping the ones already missed
+    next += this->options.interval;
+    while (next <= Clock::now()) {
+      next += this->options.interval;
+    }
+    std::this_thread::sleep_until(next);
+  }
+
+  this->Report(Clock::now());
+  return 0;
+}
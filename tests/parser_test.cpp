@@ -0,0 +1,172 @@
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "linux_parser.h"
+#include "proc_stat.h"
+#include "string_pool.h"
+#include "watcher.h"
+
+/*
+Checks of the functions that parse a buffer, and of the containers they
+fill. Each failed check is reported; the exit status is the failure count.
+*/
+
+int failures{0};
+
+#define CHECK(condition)                                           \
+  do {                                                             \
+    if (!(condition)) {                                            \
+      std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__,      \
+                   #condition);                                    \
+      ++failures;                                                  \
+    }                                                              \
+  } while (0)
+
+using namespace LinuxParser::StatFields;
+
+void TestStat() {
+  LinuxParser::ProcessStat stat;
+  // comm may hold spaces and parentheses: fields start after the last ')'
+  std::string_view line{
+      "42 (a) b (c)) S 1 42 42 0 -1 4194560 100 0 0 0 25 7 3 2 20 0 4 0 "
+      "1234 4096 300 18446744073709551615\n"};
+  CHECK((LinuxParser::ParseStat<State, Ppid, Utime, Stime, NumThreads,
+                                Starttime, Vsize, Rss>(line, stat)));
+  CHECK(std::string_view(stat.comm.data()) == "a) b (c)");
+  CHECK(stat.state == 'S');
+  CHECK(stat.ppid == 1);
+  CHECK(stat.utime == 25);
+  CHECK(stat.stime == 7);
+  CHECK(stat.num_threads == 4);
+  CHECK(stat.starttime == 1234);
+  CHECK(stat.vsize == 4096);
+  CHECK(stat.rss == 300);
+
+  // comm is cut to the 15 characters the kernel keeps
+  LinuxParser::ProcessStat longer;
+  CHECK(LinuxParser::ParseStat<State>("7 (0123456789abcdefgh) R", longer));
+  CHECK(std::string_view(longer.comm.data()) == "0123456789abcde");
+
+  // the state is a single character
+  LinuxParser::ProcessStat state;
+  CHECK(!LinuxParser::ParseStat<State>("1 (init) SS 0", state));
+  CHECK(LinuxParser::ParseStat<State>("1 (init) Z 0", state));
+  CHECK(state.state == 'Z');
+
+  // a line cut before the requested fields
+  LinuxParser::ProcessStat truncated;
+  CHECK(!(LinuxParser::ParseStat<Utime, Stime>(
+      "42 (cat) R 1 42 42 0 -1 4194560 100 0 0 0 25", truncated)));
+  CHECK(!LinuxParser::ParseStat<State>("42 (cat", truncated));
+  CHECK(!LinuxParser::ParseStat<State>("", truncated));
+
+  // fields that are not numbers, or not entirely
+  LinuxParser::ProcessStat invalid;
+  CHECK(!LinuxParser::ParseStat<Ppid>("42 (cat) R x1", invalid));
+  CHECK(!LinuxParser::ParseStat<Ppid>("42 (cat) R 1x", invalid));
+  CHECK(!LinuxParser::ParseStat<Utime>(
+      "42 (cat) R 1 42 42 0 -1 4194560 100 0 0 0 -25", invalid));
+}
+
+void TestIo() {
+  auto io = LinuxParser::ParseIo(
+      "rchar: 10\nwchar: 20\nsyscr: 1\nsyscw: 2\nread_bytes: 4096\n"
+      "write_bytes: 8192\ncancelled_write_bytes: 0\n");
+  CHECK(io.read_bytes == 4096);
+  CHECK(io.write_bytes == 8192);
+
+  auto empty = LinuxParser::ParseIo("rchar: 10\nread_bytes: x\n");
+  CHECK(empty.read_bytes == 0);
+  CHECK(empty.write_bytes == 0);
+}
+
+void TestSchedstat() {
+  auto schedstat = LinuxParser::ParseSchedstat("123456789 2000 17\n");
+  CHECK(schedstat.run_time == 123456789);
+  CHECK(schedstat.wait_time == 2000);
+  CHECK(schedstat.timeslices == 17);
+
+  auto truncated = LinuxParser::ParseSchedstat("123");
+  CHECK(truncated.run_time == 123);
+  CHECK(truncated.wait_time == 0);
+}
+
+void TestUid() {
+  CHECK(LinuxParser::ParseUid("Name:\tcat\nUmask:\t0022\nState:\tR\n"
+                              "Uid:\t1000\t0\t0\t0\nGid:\t100\t100\n") ==
+        1000);
+  CHECK(LinuxParser::ParseUid("Name:\tcat\nGid:\t100\n") == -1);
+}
+
+void TestMemory() {
+  auto memory = LinuxParser::ParseMemory(
+      "560e99c00000-7ffeb1e22000 ---p 00000000 00:00 0   [rollup]\n"
+      "Rss:                1412 kB\n"
+      "Pss:                 475 kB\n"
+      "Pss_Anon:            104 kB\n"
+      "Pss_File:            371 kB\n"
+      "Pss_Shmem:             0 kB\n"
+      "Shared_Clean:       1268 kB\n"
+      "Private_Clean:        40 kB\n"
+      "Private_Dirty:       104 kB\n"
+      "Swap:                  8 kB\n"
+      "SwapPss:               4 kB\n");
+  CHECK(memory.pss == 475);
+  CHECK(memory.pss_anon == 104);
+  CHECK(memory.pss_file == 371);
+  CHECK(memory.private_clean == 40);
+  CHECK(memory.private_dirty == 104);
+  CHECK(memory.swap == 8);
+
+  // kernels before 5.13 have no Pss_Anon/Pss_File lines
+  auto old =
+      LinuxParser::ParseMemory("0-1 ---p 0 00:00 0 [rollup]\nPss: 9 kB\n");
+  CHECK(old.pss == 9);
+  CHECK(old.pss_anon == 0);
+}
+
+void TestRingBuffer() {
+  RingBuffer<int> ring(3);
+  CHECK(ring.Size() == 0);
+  ring.Push(1);
+  ring.Push(2);
+  CHECK(ring.Size() == 2);
+  CHECK(ring[0] == 1);
+  ring.Push(3);
+  ring.Push(4);
+  CHECK(ring.Size() == 3);
+  CHECK(ring[0] == 2);
+  CHECK(ring[2] == 4);
+}
+
+void TestStringPool() {
+  StringPool pool;
+  CHECK(pool.Get(StringPool::kEmpty).empty());
+  auto bash = pool.Intern("bash");
+  CHECK(pool.Intern("bash") == bash);
+  CHECK(pool.Get(bash) == "bash");
+  CHECK(pool.Intern("") == StringPool::kEmpty);
+
+  // the id survives until its last reference is released
+  pool.Release(bash);
+  CHECK(pool.Get(bash) == "bash");
+  pool.Release(bash);
+  auto vim = pool.Intern("vim");
+  CHECK(vim == bash);
+  CHECK(pool.Get(vim) == "vim");
+}
+
+int main() {
+  TestStat();
+  TestIo();
+  TestSchedstat();
+  TestUid();
+  TestMemory();
+  TestRingBuffer();
+  TestStringPool();
+  if (failures == 0) {
+    std::printf("all checks passed\n");
+  }
+  return failures;
+}